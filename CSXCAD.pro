@@ -40,6 +40,8 @@ unix:!macx {
     DEFINES += TIXML_USE_STL
     LIBS += -lhdf5_hl -lhdf5
     LIBS += -lCGAL
+    LIBS += -lboost_thread -lboost_system
+    LIBS += -lz
 
     #vtk
     isEmpty(VTK_INCLUDEPATH) {
@@ -105,6 +107,7 @@ macx {
     DEFINES += TIXML_USE_STL
     LIBS += -lhdf5_hl -lhdf5
     LIBS += -lCGAL
+    LIBS += -lz
 
     #vtk5 provided with Homebrew
     isEmpty(VTK_INCLUDEPATH) {
@@ -136,6 +139,10 @@ macx {
 # vtk includes deprecated header files; silence the corresponding warning
 QMAKE_CXXFLAGS += -Wno-deprecated -frounding-math
 
+# the batch point tests (IsInsideBatch, CSGeometrySnapshot) and batch transforms are written for auto-vectorization
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3 -ftree-vectorize
+
 # enable this flag to use with valgrind! valgrind emulates a buggy FPU
 # QMAKE_CXXFLAGS += -DCGAL_DISABLE_ROUNDING_MATH_CHECK=ON
 
@@ -166,6 +173,8 @@ PUB_HEADERS += src/ContinuousStructure.h \
     src/CSPrimCurve.h \
     src/CSPrimWire.h \
     src/CSPrimUserDefined.h \
+    src/CSPrimInstance.h \
+    src/CSPrimCSG.h \
     src/CSPropUnknown.h \
     src/CSPropMaterial.h \
     src/CSPropDispersiveMaterial.h \
@@ -178,10 +187,14 @@ PUB_HEADERS += src/ContinuousStructure.h \
     src/CSPropExcitation.h \
     src/CSPropProbeBox.h \
     src/CSPropDumpBox.h \
-    src/CSPropResBox.h
+    src/CSPropResBox.h \
+    src/CSGeometrySnapshot.h \
+    src/CSRasterGrid.h
 
 HEADERS += $$PUB_HEADERS \
-    src/CSPrimPolyhedron_p.h
+    src/CSPrimPolyhedron_p.h \
+    src/CSXMLStreamScanner.h \
+    src/CSArena.h
 
 SOURCES += src/ContinuousStructure.cpp \
     src/CSPrimitives.cpp \
@@ -207,6 +220,8 @@ SOURCES += src/ContinuousStructure.cpp \
     src/CSPrimCurve.cpp \
     src/CSPrimWire.cpp \
     src/CSPrimUserDefined.cpp \
+    src/CSPrimInstance.cpp \
+    src/CSPrimCSG.cpp \
     src/CSPropUnknown.cpp \
     src/CSPropMaterial.cpp \
     src/CSPropDispersiveMaterial.cpp \
@@ -220,7 +235,11 @@ SOURCES += src/ContinuousStructure.cpp \
     src/CSPropProbeBox.cpp \
     src/CSPropDumpBox.cpp \
     src/CSPropResBox.cpp \
-    src/CSBackgroundMaterial.cpp
+    src/CSBackgroundMaterial.cpp \
+    src/CSXMLStreamScanner.cpp \
+    src/CSGeometrySnapshot.cpp \
+    src/CSRasterGrid.cpp \
+    src/CSArena.cpp
 
 #
 # create tar file
@@ -0,0 +1,143 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CSArena.h"
+#include "CSXCAD_Global.h"
+#include <new>
+
+//! Every allocation is preceded by this header, the union keeps the object aligned.
+union CSArenaHeader
+{
+	struct
+	{
+		CSArena* arena;
+		size_t size;
+	} info;
+	double align[2];
+};
+
+//! The current arena of each thread, a plain thread local pointer to keep the lookup per allocation cheap.
+static CSXCAD_THREAD_LOCAL CSArena* g_CurrentArena = NULL;
+
+CSArena::CSArena(size_t chunkSize)
+{
+	// a chunk has to hold a block of the largest size class
+	if (chunkSize<QTY_SIZE_CLASSES*GRANULARITY)
+		chunkSize = QTY_SIZE_CLASSES*GRANULARITY;
+	m_ChunkSize = chunkSize;
+	m_Current = NULL;
+	m_ChunkPos = 0;
+	m_TotalSize = 0;
+	m_QtyObjects = 0;
+	m_Released = false;
+	for (size_t n=0;n<QTY_SIZE_CLASSES;++n)
+		m_FreeLists[n] = NULL;
+}
+
+CSArena::~CSArena()
+{
+	for (size_t n=0;n<m_Chunks.size();++n)
+		::operator delete(m_Chunks.at(n));
+}
+
+CSArena* CSArena::SetCurrent(CSArena* arena)
+{
+	CSArena* previous = g_CurrentArena;
+	g_CurrentArena = arena;
+	return previous;
+}
+
+CSArena* CSArena::GetCurrent()
+{
+	return g_CurrentArena;
+}
+
+void* CSArena::Allocate(size_t size)
+{
+	// round up to the size class, this keeps all following allocations aligned
+	size_t block_size = (sizeof(CSArenaHeader) + size + GRANULARITY-1) & ~(GRANULARITY-1);
+	CSArena* arena = g_CurrentArena;
+	if (block_size>QTY_SIZE_CLASSES*GRANULARITY)
+		arena = NULL;
+	CSArenaHeader* header;
+	if (arena)
+		header = (CSArenaHeader*)arena->AllocateBlock(block_size);
+	else
+		header = (CSArenaHeader*)::operator new(block_size);
+	header->info.arena = arena;
+	header->info.size = block_size;
+	return header+1;
+}
+
+void CSArena::Free(void* ptr)
+{
+	if (ptr==NULL)
+		return;
+	CSArenaHeader* header = ((CSArenaHeader*)ptr)-1;
+	CSArena* arena = header->info.arena;
+	if (arena==NULL)
+	{
+		::operator delete(header);
+		return;
+	}
+	if (arena->FreeBlock(header,header->info.size))
+		delete arena;
+}
+
+void CSArena::Release()
+{
+	m_Released = true;
+	if (m_QtyObjects==0)
+		delete this;
+}
+
+void* CSArena::AllocateBlock(size_t size)
+{
+	++m_QtyObjects;
+
+	// reuse a freed block of the same size class
+	void*& head = m_FreeLists[size/GRANULARITY-1];
+	if (head)
+	{
+		void* block = head;
+		head = *(void**)block;
+		return block;
+	}
+
+	if ((m_Current==NULL) || (m_ChunkPos+size>m_ChunkSize))
+	{
+		m_Current = (char*)::operator new(m_ChunkSize);
+		m_Chunks.push_back(m_Current);
+		m_TotalSize += m_ChunkSize;
+		m_ChunkPos = 0;
+	}
+	void* block = m_Current+m_ChunkPos;
+	m_ChunkPos += size;
+	return block;
+}
+
+bool CSArena::FreeBlock(void* block, size_t size)
+{
+	--m_QtyObjects;
+	// a released arena drops all chunks at once, no need to recycle the block
+	if (m_Released)
+		return (m_QtyObjects==0);
+	void*& head = m_FreeLists[size/GRANULARITY-1];
+	*(void**)block = head;
+	head = block;
+	return false;
+}
@@ -0,0 +1,96 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSARENA_H
+#define CSARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+using namespace std;
+
+//! Arena allocator for the objects of a structure
+/*!
+ The memory is taken from large chunks by bumping a pointer, objects allocated one after the other are laid out contiguously.
+ Freed memory is kept in intrusive free lists per size class for reuse, blocks larger than the largest size class are taken from the heap.
+ Allocations are taken from the current arena of the calling thread (see Scope), or from the heap if there is none.
+ Every allocation remembers its arena, thus an object can be deleted anywhere and anytime.
+
+ An arena is owned by a single structure and is not thread-safe: allocating and freeing objects of the same arena must not happen concurrently, just like modifying the structure itself.
+ \sa ContinuousStructure::clear
+ */
+class CSArena
+{
+public:
+	CSArena(size_t chunkSize=262144);
+
+	//! Allocate memory from the current arena of the calling thread or from the heap.
+	static void* Allocate(size_t size);
+	//! Free memory allocated by Allocate.
+	static void Free(void* ptr);
+
+	//! Set the current arena of the calling thread. \return The previous arena.
+	static CSArena* SetCurrent(CSArena* arena);
+	static CSArena* GetCurrent();
+
+	//! Release this arena, all chunks are dropped at once as soon as no object is left.
+	/*!
+	 Objects freed after the release are only counted, their memory is not recycled anymore.
+	 Note: a single object surviving the release (e.g. a primitive still referenced by the caller) keeps all chunks of the arena alive until it is deleted.
+	 */
+	void Release();
+
+	//! Get the number of objects currently allocated from this arena.
+	size_t GetQtyObjects() const {return m_QtyObjects;}
+	//! Get the total size of all chunks of this arena.
+	size_t GetChunkSize() const {return m_TotalSize;}
+
+	//! Set the current arena of the calling thread within a scope.
+	class Scope
+	{
+	public:
+		Scope(CSArena* arena) {m_Previous=SetCurrent(arena);}
+		~Scope() {SetCurrent(m_Previous);}
+	protected:
+		CSArena* m_Previous;
+	};
+
+protected:
+	~CSArena();
+
+	//! Granularity of the size classes, the size of the block header.
+	static const size_t GRANULARITY = 16;
+	//! Number of size classes, larger blocks are taken from the heap.
+	static const size_t QTY_SIZE_CLASSES = 64;
+
+	size_t m_ChunkSize;
+	vector<char*> m_Chunks;
+	//! The chunk used for new allocations and the position within.
+	char* m_Current;
+	size_t m_ChunkPos;
+	size_t m_TotalSize;
+	size_t m_QtyObjects;
+	bool m_Released;
+	//! Heads of the singly linked lists of freed blocks per size class.
+	void* m_FreeLists[QTY_SIZE_CLASSES];
+
+	void* AllocateBlock(size_t size);
+	//! Free a block. \return true if the arena has to be deleted.
+	bool FreeBlock(void* block, size_t size);
+};
+
+#endif // CSARENA_H
@@ -0,0 +1,507 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CSGeometrySnapshot.h"
+#include "ContinuousStructure.h"
+#include "CSPrimBox.h"
+#include "CSPrimMultiBox.h"
+#include "CSPrimSphere.h"
+#include "CSPrimSphericalShell.h"
+#include "CSPrimCylinder.h"
+#include "CSPrimCylindricalShell.h"
+#include "CSPrimPolygon.h"
+#include "CSPrimLinPoly.h"
+#include "CSTransform.h"
+
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+
+//! Number of coordinates classified at once by ClassifyBatch.
+#define CSGEOMETRYSNAPSHOT_CHUNK 256
+
+CSGeometrySnapshot::CSGeometrySnapshot()
+{
+	m_QtyGeneric = 0;
+	m_Structure = NULL;
+	m_StructRevision = 0;
+	m_UpdateRevision = CSPrimitives::GetGlobalUpdateRevision();
+}
+
+CSGeometrySnapshot::~CSGeometrySnapshot()
+{
+}
+
+void CSGeometrySnapshot::Clear()
+{
+	m_PropTable.clear();
+	m_QtyGeneric = 0;
+	m_Primitives.clear();
+	m_Shape.clear();
+	m_ShapeIndex.clear();
+	m_ShapeCount.clear();
+	m_Priority.clear();
+	m_PropIndex.clear();
+	m_TransformIndex.clear();
+	m_InvMatrix.clear();
+	m_DistScale.clear();
+	m_BoundBoxValid.clear();
+	for (int n=0;n<6;++n)
+		m_BoundBox[n].clear();
+	for (int n=0;n<3;++n)
+	{
+		m_BoxLo[n].clear();
+		m_BoxHi[n].clear();
+		m_SphereCenter[n].clear();
+		m_CylStart[n].clear();
+		m_CylDir[n].clear();
+	}
+	m_SphereInnerSq.clear();
+	m_SphereOuterSq.clear();
+	m_CylLength.clear();
+	m_CylInnerSq.clear();
+	m_CylOuterSq.clear();
+	m_PolyNormDir.clear();
+	m_PolyStart.clear();
+	m_PolyCount.clear();
+	for (int n=0;n<6;++n)
+		m_PolyBox[n].clear();
+	m_PolyCoords.clear();
+}
+
+bool CSGeometrySnapshot::Freeze(ContinuousStructure* csx, CSProperties::PropertyType type)
+{
+	Clear();
+	m_Structure = csx;
+	m_StructRevision = csx ? csx->GetRevision() : 0;
+	m_UpdateRevision = CSPrimitives::GetGlobalUpdateRevision();
+	if (csx==NULL)
+	{
+		cerr << __func__ << ": Error, no structure given" << endl;
+		return false;
+	}
+	bool cartesian = (csx->GetGrid()->GetMeshType()==CARTESIAN);
+	for (size_t i=0;i<csx->GetQtyProperties();++i)
+	{
+		CSProperties* prop = csx->GetProperty(i);
+		if ((type!=CSProperties::ANY) && ((prop->GetType() & type)==0))
+			continue;
+		if (prop->GetQtyPrimitives()==0)
+			continue;
+		m_PropTable.push_back(prop);
+		for (size_t j=0;j<prop->GetQtyPrimitives();++j)
+			AddPrimitive(prop->GetPrimitive(j),m_PropTable.size()-1,cartesian);
+	}
+	return true;
+}
+
+bool CSGeometrySnapshot::IsCurrent() const
+{
+	if (m_Structure && (m_StructRevision!=m_Structure->GetRevision()))
+		return false;
+	return (m_UpdateRevision==CSPrimitives::GetGlobalUpdateRevision());
+}
+
+void CSGeometrySnapshot::AddPrimitive(CSPrimitives* prim, int propIndex, bool cartesian)
+{
+	m_Primitives.push_back(prim);
+	m_Priority.push_back(prim->GetPriority());
+	m_PropIndex.push_back(propIndex);
+	m_DistScale.push_back(prim->GetTransformDistanceScale());
+
+	// the bounding box is cartesian, it can not be compared to the coordinates of a non-cartesian mesh
+	double box[6];
+	bool box_valid = cartesian && (prim->GetCoordInputType()==CARTESIAN) && prim->GetTransformedBoundBox(box);
+	if (!box_valid)
+		for (int n=0;n<6;++n)
+			box[n] = 0;
+	m_BoundBoxValid.push_back(box_valid);
+	for (int n=0;n<6;++n)
+		m_BoundBox[n].push_back(box[n]);
+
+	// the shape arrays hold cartesian coordinates in the frame of the primitive only
+	bool simple = cartesian && (prim->GetCoordInputType()==CARTESIAN);
+	CSTransform* transform = prim->GetTransform();
+	if (simple && transform)
+	{
+		m_TransformIndex.push_back(m_InvMatrix.size()/16);
+		const double* inv = transform->GetInverseMatrix();
+		m_InvMatrix.insert(m_InvMatrix.end(),inv,inv+16);
+	}
+	else
+		m_TransformIndex.push_back(-1);
+
+	int prim_type = prim->GetType();
+	if (simple && ((prim->GetCoordinateSystem()==UNDEFINED_CS) || (prim->GetCoordinateSystem()==CARTESIAN)) && (prim_type==CSPrimitives::BOX))
+	{
+		CSPrimBox* prim_box = prim->ToBox();
+		const double* start = prim_box->GetStartCoord()->GetCartesianCoords();
+		const double* stop = prim_box->GetStopCoord()->GetCartesianCoords();
+		m_Shape.push_back(SHAPE_BOX);
+		m_ShapeIndex.push_back(m_BoxLo[0].size());
+		m_ShapeCount.push_back(1);
+		for (int n=0;n<3;++n)
+		{
+			m_BoxLo[n].push_back(min(start[n],stop[n]));
+			m_BoxHi[n].push_back(max(start[n],stop[n]));
+		}
+		return;
+	}
+	if (simple && (prim_type==CSPrimitives::MULTIBOX))
+	{
+		CSPrimMultiBox* multi_box = prim->ToMultiBox();
+		m_Shape.push_back(SHAPE_BOX);
+		m_ShapeIndex.push_back(m_BoxLo[0].size());
+		m_ShapeCount.push_back(multi_box->GetQtyBoxes());
+		for (unsigned int i=0;i<multi_box->GetQtyBoxes();++i)
+			for (int n=0;n<3;++n)
+			{
+				double down = multi_box->GetCoord(6*i+2*n);
+				double up = multi_box->GetCoord(6*i+2*n+1);
+				m_BoxLo[n].push_back(min(down,up));
+				m_BoxHi[n].push_back(max(down,up));
+			}
+		return;
+	}
+	if (simple && ((prim_type==CSPrimitives::SPHERE) || (prim_type==CSPrimitives::SPHERICALSHELL)))
+	{
+		// the squared radii of CSPrimSphere and CSPrimSphericalShell, updated by their Update()
+		CSPrimSphere* sphere = static_cast<CSPrimSphere*>(prim);
+		const double* center = sphere->GetCenter()->GetCartesianCoords();
+		double inner = -1;
+		double outer = sphere->GetRadiusSq();
+		if (prim_type==CSPrimitives::SPHERICALSHELL)
+		{
+			inner = prim->ToSphericalShell()->GetInnerRadiusSq();
+			outer = prim->ToSphericalShell()->GetOuterRadiusSq();
+		}
+		m_Shape.push_back(SHAPE_SPHERE);
+		m_ShapeIndex.push_back(m_SphereInnerSq.size());
+		m_ShapeCount.push_back(1);
+		for (int n=0;n<3;++n)
+			m_SphereCenter[n].push_back(center[n]);
+		m_SphereInnerSq.push_back(inner);
+		m_SphereOuterSq.push_back(outer);
+		return;
+	}
+	if (simple && ((prim_type==CSPrimitives::CYLINDER) || (prim_type==CSPrimitives::CYLINDRICALSHELL)))
+	{
+		// the axis and squared radii of CSPrimCylinder and CSPrimCylindricalShell, updated by their Update()
+		CSPrimCylinder* cylinder = static_cast<CSPrimCylinder*>(prim);
+		const double* start = cylinder->GetAxisStartCoord()->GetCartesianCoords();
+		const double* dir = cylinder->GetAxisDir();
+		double inner = -1;
+		double outer = cylinder->GetRadiusSq();
+		if (prim_type==CSPrimitives::CYLINDRICALSHELL)
+		{
+			inner = prim->ToCylindricalShell()->GetInnerRadiusSq();
+			outer = prim->ToCylindricalShell()->GetOuterRadiusSq();
+		}
+		m_Shape.push_back(SHAPE_CYLINDER);
+		m_ShapeIndex.push_back(m_CylLength.size());
+		m_ShapeCount.push_back(1);
+		for (int n=0;n<3;++n)
+		{
+			m_CylStart[n].push_back(start[n]);
+			m_CylDir[n].push_back(dir[n]);
+		}
+		m_CylLength.push_back(cylinder->GetAxisLength());
+		m_CylInnerSq.push_back(inner);
+		m_CylOuterSq.push_back(outer);
+		return;
+	}
+	double poly_box[6];
+	if (simple && ((prim_type==CSPrimitives::POLYGON) || (prim_type==CSPrimitives::LINPOLY)) && prim->GetBoundBox(poly_box))
+	{
+		// the (untransformed) bounding box limits the polygon plane or the extrusion, see CSPrimPolygon::IsInside
+		CSPrimPolygon* polygon = static_cast<CSPrimPolygon*>(prim);
+		const vector<double>& vertices = polygon->GetVertexCoords();
+		m_Shape.push_back(SHAPE_POLYGON);
+		m_ShapeIndex.push_back(m_PolyNormDir.size());
+		m_ShapeCount.push_back(1);
+		m_PolyNormDir.push_back(polygon->GetNormDir());
+		m_PolyStart.push_back(m_PolyCoords.size());
+		m_PolyCount.push_back(vertices.size()/2);
+		for (int n=0;n<6;++n)
+			m_PolyBox[n].push_back(poly_box[n]);
+		m_PolyCoords.insert(m_PolyCoords.end(),vertices.begin(),vertices.end());
+		return;
+	}
+
+	// the primitive transforms the coordinates itself
+	if (m_TransformIndex.back()>=0)
+	{
+		m_InvMatrix.resize(m_InvMatrix.size()-16);
+		m_TransformIndex.back() = -1;
+	}
+	m_Shape.push_back(SHAPE_GENERIC);
+	m_ShapeIndex.push_back(0);
+	m_ShapeCount.push_back(1);
+	++m_QtyGeneric;
+}
+
+bool CSGeometrySnapshot::GetBoundBox(size_t n, double box[6]) const
+{
+	if (m_BoundBoxValid.at(n)==0)
+		return false;
+	for (int i=0;i<6;++i)
+		box[i] = m_BoundBox[i][n];
+	return true;
+}
+
+void CSGeometrySnapshot::GetBox(size_t n, size_t k, double box[6]) const
+{
+	if (k>=GetQtyBoxes(n))
+	{
+		cerr << __func__ << ": Error, invalid box index" << endl;
+		return;
+	}
+	size_t b = m_ShapeIndex[n]+k;
+	for (int i=0;i<3;++i)
+	{
+		box[2*i] = m_BoxLo[i][b];
+		box[2*i+1] = m_BoxHi[i][b];
+	}
+}
+
+bool CSGeometrySnapshot::IsInsidePolygon(size_t n, double x, double y) const
+{
+	if (m_PolyCount[n]==0)
+		return false;
+	return CSPrimPolygon::IsInsidePolygon(m_PolyCount[n],&m_PolyCoords[m_PolyStart[n]],x,y);
+}
+
+bool CSGeometrySnapshot::GetSignedDistance(size_t n, const double coord[3], double &dist) const
+{
+	if (m_Shape[n]==SHAPE_GENERIC)
+		return m_Primitives[n]->GetSignedDistance(coord,dist);
+	if (m_Shape[n]==SHAPE_POLYGON)
+		return false;
+
+	// the distance is calculated in the frame of the primitive and scaled into the mesh
+	double pos[3] = {coord[0],coord[1],coord[2]};
+	int trans = m_TransformIndex[n];
+	if (trans>=0)
+		CSTransform::MatrixTransformBatch(&m_InvMatrix[16*trans],1,&coord[0],&coord[1],&coord[2],&pos[0],&pos[1],&pos[2]);
+
+	size_t idx = m_ShapeIndex[n];
+	switch (m_Shape[n])
+	{
+	case SHAPE_BOX:
+	{
+		// the union of all boxes, the minimum is exact outside and an upper bound inside
+		if (m_ShapeCount[n]==0)
+			return false;
+		for (size_t b=idx;b<idx+m_ShapeCount[n];++b)
+		{
+			double outside = 0;
+			double inside = 0;
+			for (int i=0;i<3;++i)
+			{
+				double d = max(m_BoxLo[i][b]-pos[i], pos[i]-m_BoxHi[i][b]);
+				if (d>0)
+					outside += d*d;
+				if ((i==0) || (d>inside))
+					inside = d;
+			}
+			double box_dist = (outside>0) ? sqrt(outside) : inside;
+			if ((b==idx) || (box_dist<dist))
+				dist = box_dist;
+		}
+		break;
+	}
+	case SHAPE_SPHERE:
+	{
+		if (m_SphereOuterSq[idx]<0)
+			return false;
+		double r2 = 0;
+		for (int i=0;i<3;++i)
+			r2 += (pos[i]-m_SphereCenter[i][idx])*(pos[i]-m_SphereCenter[i][idx]);
+		double r = sqrt(r2);
+		dist = r-sqrt(m_SphereOuterSq[idx]);
+		if (m_SphereInnerSq[idx]>=0)
+			dist = max(dist,sqrt(m_SphereInnerSq[idx])-r);
+		break;
+	}
+	case SHAPE_CYLINDER:
+	{
+		if ((m_CylOuterSq[idx]<0) || (m_CylLength[idx]<=0))
+			return false;
+		double v[3];
+		double axial = 0, r2 = 0;
+		for (int i=0;i<3;++i)
+		{
+			v[i] = pos[i]-m_CylStart[i][idx];
+			axial += v[i]*m_CylDir[i][idx];
+			r2 += v[i]*v[i];
+		}
+		double r = sqrt(max(r2-axial*axial,0.0));
+		double radial = r-sqrt(m_CylOuterSq[idx]);
+		if (m_CylInnerSq[idx]>=0)
+			radial = max(radial,sqrt(m_CylInnerSq[idx])-r);
+		dist = Orthogonal_Distance(radial,max(-axial,axial-m_CylLength[idx]));
+		break;
+	}
+	default:
+		return false;
+	}
+	dist *= m_DistScale[n];
+	return true;
+}
+
+void CSGeometrySnapshot::IsInsideBatch(size_t n, size_t num, const double* x, const double* y, const double* z, bool* inside) const
+{
+	int trans = m_TransformIndex[n];
+	if (trans<0)
+		return IsInsideShape(n,num,x,y,z,inside);
+
+	// map the coordinates into the frame of the primitive, chunk by chunk
+	double tx[CSGEOMETRYSNAPSHOT_CHUNK], ty[CSGEOMETRYSNAPSHOT_CHUNK], tz[CSGEOMETRYSNAPSHOT_CHUNK];
+	const double* inv = &m_InvMatrix[16*trans];
+	for (size_t offset=0;offset<num;offset+=CSGEOMETRYSNAPSHOT_CHUNK)
+	{
+		size_t chunk = min((size_t)CSGEOMETRYSNAPSHOT_CHUNK,num-offset);
+		CSTransform::MatrixTransformBatch(inv,chunk,x+offset,y+offset,z+offset,tx,ty,tz);
+		IsInsideShape(n,chunk,tx,ty,tz,inside+offset);
+	}
+}
+
+void CSGeometrySnapshot::IsInsideShape(size_t n, size_t num, const double* x, const double* y, const double* z, bool* inside) const
+{
+	size_t idx = m_ShapeIndex[n];
+	switch (m_Shape[n])
+	{
+	case SHAPE_BOX:
+	{
+		std::fill(inside,inside+num,false);
+		for (size_t b=idx;b<idx+m_ShapeCount[n];++b)
+		{
+			const double x0=m_BoxLo[0][b], x1=m_BoxHi[0][b];
+			const double y0=m_BoxLo[1][b], y1=m_BoxHi[1][b];
+			const double z0=m_BoxLo[2][b], z1=m_BoxHi[2][b];
+			// no branches inside the loop, to allow auto-vectorization
+			for (size_t i=0;i<num;++i)
+				inside[i] |= (x[i]>=x0) & (x[i]<=x1) & (y[i]>=y0) & (y[i]<=y1) & (z[i]>=z0) & (z[i]<=z1);
+		}
+		return;
+	}
+	case SHAPE_SPHERE:
+	{
+		const double cx=m_SphereCenter[0][idx], cy=m_SphereCenter[1][idx], cz=m_SphereCenter[2][idx];
+		const double r2_in=m_SphereInnerSq[idx], r2_out=m_SphereOuterSq[idx];
+		for (size_t i=0;i<num;++i)
+		{
+			double dx=x[i]-cx, dy=y[i]-cy, dz=z[i]-cz;
+			double dist2 = dx*dx+dy*dy+dz*dz;
+			inside[i] = (dist2>r2_in) & (dist2<r2_out);
+		}
+		return;
+	}
+	case SHAPE_CYLINDER:
+	{
+		const double sx=m_CylStart[0][idx], sy=m_CylStart[1][idx], sz=m_CylStart[2][idx];
+		const double ux=m_CylDir[0][idx], uy=m_CylDir[1][idx], uz=m_CylDir[2][idx];
+		const double len=m_CylLength[idx], r2_in=m_CylInnerSq[idx], r2_out=m_CylOuterSq[idx];
+		for (size_t i=0;i<num;++i)
+		{
+			double vx=x[i]-sx, vy=y[i]-sy, vz=z[i]-sz;
+			double axial = vx*ux+vy*uy+vz*uz;
+			double radial2 = vx*vx+vy*vy+vz*vz-axial*axial;
+			inside[i] = (axial>=0) & (axial<=len) & (radial2>=r2_in) & (radial2<=r2_out);
+		}
+		return;
+	}
+	case SHAPE_POLYGON:
+	{
+		int nP = (m_PolyNormDir[idx]+1)%3;
+		int nPP = (m_PolyNormDir[idx]+2)%3;
+		const double* coords[3] = {x,y,z};
+		for (size_t i=0;i<num;++i)
+		{
+			inside[i] = false;
+			bool in_box = true;
+			for (int d=0;d<3;++d)
+				in_box &= (coords[d][i]>=m_PolyBox[2*d][idx]) && (coords[d][i]<=m_PolyBox[2*d+1][idx]);
+			if (in_box)
+				inside[i] = IsInsidePolygon(idx,coords[nP][i],coords[nPP][i]);
+		}
+		return;
+	}
+	default:
+		m_Primitives[n]->IsInsideBatch(num,x,y,z,inside);
+		return;
+	}
+}
+
+void CSGeometrySnapshot::ClassifyBatch(size_t num, const double* x, const double* y, const double* z, int* index) const
+{
+	if (IsCurrent()==false)
+	{
+		cerr << __func__ << ": Error, the structure was modified, the snapshot has to be frozen again" << endl;
+		std::fill(index,index+num,-1);
+		return;
+	}
+
+	bool inside[CSGEOMETRYSNAPSHOT_CHUNK];
+	int found[CSGEOMETRYSNAPSHOT_CHUNK];
+	for (size_t offset=0;offset<num;offset+=CSGEOMETRYSNAPSHOT_CHUNK)
+	{
+		size_t chunk = min((size_t)CSGEOMETRYSNAPSHOT_CHUNK,num-offset);
+		const double* cx = x+offset;
+		const double* cy = y+offset;
+		const double* cz = z+offset;
+
+		// primitives outside of the bounds of all coordinates of this chunk are skipped
+		double lo[3] = {cx[0],cy[0],cz[0]};
+		double hi[3] = {cx[0],cy[0],cz[0]};
+		for (size_t i=1;i<chunk;++i)
+		{
+			lo[0] = min(lo[0],cx[i]); hi[0] = max(hi[0],cx[i]);
+			lo[1] = min(lo[1],cy[i]); hi[1] = max(hi[1],cy[i]);
+			lo[2] = min(lo[2],cz[i]); hi[2] = max(hi[2],cz[i]);
+		}
+
+		for (size_t i=0;i<chunk;++i)
+			found[i] = -1;
+		for (size_t n=0;n<m_Shape.size();++n)
+		{
+			if (m_BoundBoxValid[n])
+			{
+				bool outside = false;
+				for (int d=0;d<3;++d)
+					outside |= (m_BoundBox[2*d+1][n]<lo[d]) || (m_BoundBox[2*d][n]>hi[d]);
+				if (outside)
+					continue;
+			}
+			IsInsideBatch(n,chunk,cx,cy,cz,inside);
+			// the first primitive (in search order) of highest priority wins
+			int prio = m_Priority[n];
+			for (size_t i=0;i<chunk;++i)
+				if (inside[i] && ((found[i]<0) || (prio>m_Priority[found[i]])))
+					found[i] = n;
+		}
+		for (size_t i=0;i<chunk;++i)
+			index[offset+i] = (found[i]<0) ? -1 : m_PropIndex[found[i]];
+	}
+}
+
+int CSGeometrySnapshot::Classify(const double coord[3]) const
+{
+	int index;
+	ClassifyBatch(1,&coord[0],&coord[1],&coord[2],&index);
+	return index;
+}
@@ -0,0 +1,156 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSGEOMETRYSNAPSHOT_H
+#define CSGEOMETRYSNAPSHOT_H
+
+#include <vector>
+#include "CSXCAD_Global.h"
+#include "CSProperties.h"
+
+class ContinuousStructure;
+class CSPrimitives;
+
+//! Frozen, evaluated geometry of a structure for fast (batch) point queries.
+/*!
+ Freeze copies the evaluated parameters of all primitives of interest into flat arrays, one set of arrays per shape type (structure of arrays).
+ Boxes, multi-boxes, spheres, spherical shells, cylinders, cylindrical shells, polygons and extruded polygons in a cartesian mesh are tested on these arrays only.
+ The coordinates of a primitive with a transformation are mapped into its frame using a copy of the inverse transformation matrix (see CSTransform::MatrixTransformBatch).
+ All other primitives (e.g. in a non-cartesian mesh) are kept as generic shapes and are tested by CSPrimitives::IsInsideBatch.
+ The primitives are stored in the order of the priority search of ContinuousStructure::GetPropertyByCoordPriority and the same winner is found.
+ The snapshot is not updated automatically, it has to be frozen again after the structure was changed or updated (see IsCurrent).
+ A snapshot that is not current refuses to classify, as its primitives may have been modified or deleted.
+ */
+class CSXCAD_EXPORT CSGeometrySnapshot
+{
+public:
+	//! Shape types of the snapshot.
+	enum ShapeType
+	{
+		SHAPE_BOX, SHAPE_SPHERE, SHAPE_CYLINDER, SHAPE_POLYGON, SHAPE_GENERIC
+	};
+
+	CSGeometrySnapshot();
+	virtual ~CSGeometrySnapshot();
+
+	//! Freeze the current state of the given structure, ContinuousStructure::Update has to be called before.
+	/*!
+	 \param csx The structure, only the pointers to its properties and primitives are kept.
+	 \param type Property type(s) of interest, e.g. CSProperties::MATERIAL.
+	 \return false if the structure is invalid.
+	 */
+	bool Freeze(ContinuousStructure* csx, CSProperties::PropertyType type=CSProperties::ANY);
+	//! Remove all primitives from the snapshot.
+	void Clear();
+	//! Check if no primitive was updated, added or removed and no property was modified since Freeze. \sa CSPrimitives::GetGlobalUpdateRevision ContinuousStructure::GetRevision
+	bool IsCurrent() const;
+
+	//! Get the number of primitives in the snapshot.
+	size_t GetQtyPrimitives() const {return m_Shape.size();}
+	//! Get the number of primitives that have to be tested by the primitive itself. \sa SHAPE_GENERIC
+	size_t GetQtyGeneric() const {return m_QtyGeneric;}
+
+	//! Get the primitive the n-th entry was frozen from.
+	CSPrimitives* GetPrimitive(size_t n) const {return m_Primitives.at(n);}
+	//! Get the shape type of the n-th primitive.
+	ShapeType GetShapeType(size_t n) const {return (ShapeType)m_Shape.at(n);}
+	//! Get the priority of the n-th primitive.
+	int GetPriority(size_t n) const {return m_Priority.at(n);}
+	//! Get the index into the property table of the n-th primitive.
+	int GetPropertyIndex(size_t n) const {return m_PropIndex.at(n);}
+	//! Get the conservative cartesian bounding box of the n-th primitive. \return false if no bounding box is available, e.g. in a non-cartesian mesh.
+	bool GetBoundBox(size_t n, double box[6]) const;
+	//! Get the number of boxes of the n-th primitive, a multi-box has more than one box. \return 0 if the primitive is not of SHAPE_BOX.
+	size_t GetQtyBoxes(size_t n) const {return (m_Shape.at(n)==SHAPE_BOX) ? m_ShapeCount[n] : 0;}
+	//! Get the k-th box (xmin,xmax,ymin,ymax,zmin,zmax) of the n-th primitive, in the frame of the primitive. \sa GetQtyBoxes HasTransform
+	void GetBox(size_t n, size_t k, double box[6]) const;
+
+	//! Check if the n-th primitive has a transformation.
+	bool HasTransform(size_t n) const {return m_TransformIndex.at(n)>=0;}
+
+	//! Get all properties found, the property index of a primitive refers to this table.
+	const vector<CSProperties*>& GetPropertyTable() const {return m_PropTable;}
+
+	//! Get the signed distance of the given coordinate to the surface of the n-th primitive, negative inside. \sa CSPrimitives::GetSignedDistance
+	/*!
+	 Boxes, spheres and cylinders (and their shells) are evaluated on the arrays of the snapshot, generic shapes by the primitive itself.
+	 \return false if the distance is not available, e.g. for polygons.
+	 */
+	bool GetSignedDistance(size_t n, const double coord[3], double &dist) const;
+	//! Check a number of coordinates against the n-th primitive. \sa CSPrimitives::IsInsideBatch
+	void IsInsideBatch(size_t n, size_t num, const double* x, const double* y, const double* z, bool* inside) const;
+	//! Get the property table index of highest priority for a number of coordinates, -1 if no property was found or the snapshot is not current.
+	void ClassifyBatch(size_t num, const double* x, const double* y, const double* z, int* index) const;
+	//! Get the property table index of highest priority at the given coordinate, -1 if no property was found.
+	int Classify(const double coord[3]) const;
+
+protected:
+	vector<CSProperties*> m_PropTable;
+	size_t m_QtyGeneric;
+	//! The frozen structure and the revisions of the structure and the primitives at the time of Freeze. \sa IsCurrent
+	ContinuousStructure* m_Structure;
+	unsigned int m_StructRevision;
+	unsigned int m_UpdateRevision;
+
+	// common arrays, one entry per primitive
+	vector<CSPrimitives*> m_Primitives;
+	vector<unsigned char> m_Shape;
+	//! Index into the arrays of the shape type, the number of entries used (e.g. the boxes of a multi-box).
+	vector<size_t> m_ShapeIndex;
+	vector<size_t> m_ShapeCount;
+	vector<int> m_Priority;
+	vector<int> m_PropIndex;
+	//! Index into the inverse transformation matrices, -1 if the primitive has no transformation.
+	vector<int> m_TransformIndex;
+	vector<double> m_InvMatrix;
+	//! Factor to convert a distance in the frame of the primitive into the mesh. \sa CSPrimitives::GetTransformDistanceScale
+	vector<double> m_DistScale;
+	vector<double> m_BoundBox[6];
+	vector<unsigned char> m_BoundBoxValid;
+
+	// boxes, the lower and upper corner of every (sub-)box
+	vector<double> m_BoxLo[3];
+	vector<double> m_BoxHi[3];
+
+	// spheres and spherical shells, the squared radii use the strict rule dist2>inner && dist2<outer
+	vector<double> m_SphereCenter[3];
+	vector<double> m_SphereInnerSq;
+	vector<double> m_SphereOuterSq;
+
+	// cylinders and cylindrical shells, the squared radii use the inclusive rule radial2>=inner && radial2<=outer
+	vector<double> m_CylStart[3];
+	vector<double> m_CylDir[3];
+	vector<double> m_CylLength;
+	vector<double> m_CylInnerSq;
+	vector<double> m_CylOuterSq;
+
+	// polygons and extruded polygons, the vertices (x1,y1,x2,y2 ...) of all polygons are stored consecutively
+	vector<int> m_PolyNormDir;
+	vector<size_t> m_PolyStart;
+	vector<size_t> m_PolyCount;
+	vector<double> m_PolyBox[6];
+	vector<double> m_PolyCoords;
+
+	//! Add the given primitive to the snapshot, as generic shape if necessary.
+	void AddPrimitive(CSPrimitives* prim, int propIndex, bool cartesian);
+	//! Check a number of coordinates (in the frame of the primitive) against the shape of the n-th primitive.
+	void IsInsideShape(size_t n, size_t num, const double* x, const double* y, const double* z, bool* inside) const;
+	//! Point in polygon test of the n-th polygon, the point is given in the polygon plane.
+	bool IsInsidePolygon(size_t n, double x, double y) const;
+};
+
+#endif // CSGEOMETRYSNAPSHOT_H
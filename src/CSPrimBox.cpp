@@ -103,6 +103,34 @@ bool CSPrimBox::IsInside(const double* Coord, double /*tol*/)
 }
 
 
+bool CSPrimBox::GetSignedDistance(const double* Coord, double &dist)
+{
+	if (Coord==NULL) return false;
+	CoordinateSystem cs = (m_PrimCoordSystem!=UNDEFINED_CS) ? m_PrimCoordSystem : m_MeshType;
+	if (cs!=CARTESIAN)
+		return false; // a box in a cylindrical coordinate system is not supported
+
+	const double* start = m_Coords[0].GetCoords(CARTESIAN);
+	const double* stop  = m_Coords[1].GetCoords(CARTESIAN);
+	double pos[3] = {Coord[0],Coord[1],Coord[2]};
+	TransformCoords(pos, true, m_MeshType);
+	TransformCoordSystem(pos,pos,m_MeshType,CARTESIAN);
+
+	double outside = 0;
+	double inside = 0;
+	for (int n=0;n<3;++n)
+	{
+		double d = max(min(start[n],stop[n])-pos[n], pos[n]-max(start[n],stop[n]));
+		if (d>0)
+			outside += d*d;
+		if ((n==0) || (d>inside))
+			inside = d;
+	}
+	dist = (outside>0) ? sqrt(outside) : inside;
+	dist *= GetTransformDistanceScale();
+	return true;
+}
+
 bool CSPrimBox::Update(string *ErrStr)
 {
 	bool bOK=m_Coords[0].Evaluate(ErrStr) && m_Coords[1].Evaluate(ErrStr);
@@ -115,7 +143,7 @@ bool CSPrimBox::Update(string *ErrStr)
 	m_Coords[0].SetCoordinateSystem(m_PrimCoordSystem, m_MeshType);
 	m_Coords[1].SetCoordinateSystem(m_PrimCoordSystem, m_MeshType);
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 	return bOK;
 }
 
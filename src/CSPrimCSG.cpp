@@ -0,0 +1,310 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+#include <iostream>
+#include <string.h>
+#include "tinyxml.h"
+
+#include "CSPrimCSG.h"
+#include "CSProperties.h"
+#include "CSUseful.h"
+#include "ContinuousStructure.h"
+
+CSPrimCSG::CSPrimCSG(unsigned int ID, ParameterSet* paraSet, CSProperties* prop) : CSPrimitives(ID,paraSet,prop)
+{
+	Type=CSG;
+	m_Operation = UNION;
+	PrimTypeName = string("CSG");
+}
+
+CSPrimCSG::CSPrimCSG(CSPrimCSG* csg, CSProperties *prop) : CSPrimitives(csg,prop)
+{
+	Type=CSG;
+	m_Operation = csg->m_Operation;
+	for (size_t i=0;i<csg->m_Primitives.size();++i)
+		AddPrimitive(csg->m_Primitives.at(i)->GetCopy());
+	PrimTypeName = string("CSG");
+}
+
+CSPrimCSG::CSPrimCSG(ParameterSet* paraSet, CSProperties* prop) : CSPrimitives(paraSet,prop)
+{
+	Type=CSG;
+	m_Operation = UNION;
+	PrimTypeName = string("CSG");
+}
+
+CSPrimCSG::~CSPrimCSG()
+{
+	ClearPrimitives();
+}
+
+string CSPrimCSG::GetOperationName() const
+{
+	switch (m_Operation)
+	{
+	case INTERSECTION:
+		return string("Intersection");
+	case DIFFERENCE:
+		return string("Difference");
+	default:
+		return string("Union");
+	}
+}
+
+void CSPrimCSG::AddPrimitive(CSPrimitives* prim)
+{
+	if (prim==NULL)
+		return;
+	m_Primitives.push_back(prim);
+	for (int n=0;n<6;++n)
+		m_Boxes.push_back(0);
+	m_BoxValid.push_back(false);
+}
+
+CSPrimitives* CSPrimCSG::GetPrimitive(size_t index) const
+{
+	if (index<m_Primitives.size())
+		return m_Primitives.at(index);
+	return NULL;
+}
+
+void CSPrimCSG::ClearPrimitives()
+{
+	for (size_t i=0;i<m_Primitives.size();++i)
+		delete m_Primitives.at(i);
+	m_Primitives.clear();
+	m_Boxes.clear();
+	m_BoxValid.clear();
+}
+
+bool CSPrimCSG::GetBoundBox(double dBoundBox[6], bool PreserveOrientation)
+{
+	UNUSED(PreserveOrientation); //has no orientation or preserved anyways
+	m_BoundBox_CoordSys=CARTESIAN;
+	m_Dimension=0;
+	for (int n=0;n<6;++n)
+		dBoundBox[n]=0;
+	if (m_Primitives.size()==0)
+		return false;
+
+	bool found = false;
+	bool accurate = true;
+	for (size_t i=0;i<m_Primitives.size();++i)
+	{
+		if ((m_Operation==DIFFERENCE) && (i>0))
+			break;
+		m_Dimension = max(m_Dimension, m_Primitives.at(i)->GetDimension());
+		if (m_BoxValid.at(i)==false)
+		{
+			// an unknown box can only be ignored for the intersection
+			if (m_Operation!=INTERSECTION)
+				accurate = false;
+			continue;
+		}
+		const double* box = &m_Boxes.at(6*i);
+		for (int n=0;n<3;++n)
+		{
+			if ((found==false) || ((m_Operation==INTERSECTION) ? (box[2*n]>dBoundBox[2*n]) : (box[2*n]<dBoundBox[2*n])))
+				dBoundBox[2*n] = box[2*n];
+			if ((found==false) || ((m_Operation==INTERSECTION) ? (box[2*n+1]<dBoundBox[2*n+1]) : (box[2*n+1]>dBoundBox[2*n+1])))
+				dBoundBox[2*n+1] = box[2*n+1];
+		}
+		found = true;
+	}
+	// an empty intersection
+	for (int n=0;n<3;++n)
+		if (dBoundBox[2*n]>dBoundBox[2*n+1])
+		{
+			dBoundBox[2*n+1] = dBoundBox[2*n];
+			m_Dimension = 0;
+		}
+	return found && accurate;
+}
+
+bool CSPrimCSG::IsOutsideBox(size_t index, const double pos[3]) const
+{
+	if (m_BoxValid.at(index)==false)
+		return false;
+	const double* box = &m_Boxes.at(6*index);
+	for (int n=0;n<3;++n)
+		if ((pos[n]<box[2*n]) || (pos[n]>box[2*n+1]))
+			return true;
+	return false;
+}
+
+bool CSPrimCSG::IsInsidePrimitive(size_t index, const double pos[3], double tol)
+{
+	if (IsOutsideBox(index,pos))
+		return false;
+	return m_Primitives.at(index)->IsInside(pos,tol);
+}
+
+bool CSPrimCSG::IsInside(const double* Coord, double tol)
+{
+	if ((Coord==NULL) || (m_Primitives.size()==0)) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+
+	switch (m_Operation)
+	{
+	case INTERSECTION:
+		// test all bounding boxes first, before any (expensive) primitive test
+		for (size_t i=0;i<m_Primitives.size();++i)
+			if (IsOutsideBox(i,pos))
+				return false;
+		for (size_t i=0;i<m_Primitives.size();++i)
+			if (m_Primitives.at(i)->IsInside(pos,tol)==false)
+				return false;
+		return true;
+	case DIFFERENCE:
+		if (IsInsidePrimitive(0,pos,tol)==false)
+			return false;
+		for (size_t i=1;i<m_Primitives.size();++i)
+			if (IsInsidePrimitive(i,pos,tol))
+				return false;
+		return true;
+	default:
+		for (size_t i=0;i<m_Primitives.size();++i)
+			if (IsInsidePrimitive(i,pos,tol))
+				return true;
+		return false;
+	}
+}
+
+bool CSPrimCSG::GetSignedDistance(const double* Coord, double &dist)
+{
+	if ((Coord==NULL) || (m_Primitives.size()==0)) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+
+	// min/max combination of the distances, still a lower bound of the true distance
+	double child_dist;
+	for (size_t i=0;i<m_Primitives.size();++i)
+	{
+		if (m_Primitives.at(i)->GetSignedDistance(pos,child_dist)==false)
+			return false;
+		if ((m_Operation==DIFFERENCE) && (i>0))
+			child_dist = -child_dist;
+		if (i==0)
+			dist = child_dist;
+		else if (m_Operation==UNION)
+			dist = min(dist,child_dist);
+		else
+			dist = max(dist,child_dist);
+	}
+	dist *= GetTransformDistanceScale();
+	return true;
+}
+
+bool CSPrimCSG::Update(string *ErrStr)
+{
+	bool bOK=true;
+	if (m_Primitives.size()==0)
+	{
+		bOK=false;
+		if (ErrStr!=NULL)
+		{
+			stringstream stream;
+			stream << endl << "Error in " << PrimTypeName << " (ID: " << uiID << "): no primitives to combine";
+			ErrStr->append(stream.str());
+		}
+	}
+	for (size_t i=0;i<m_Primitives.size();++i)
+	{
+		// the combined primitives are always evaluated in cartesian coordinates, see IsInside
+		m_Primitives.at(i)->SetCoordInputType(CARTESIAN,false);
+		if (m_Primitives.at(i)->Update(ErrStr)==false)
+			bOK=false;
+		m_BoxValid.at(i) = m_Primitives.at(i)->GetTransformedBoundBox(&m_Boxes.at(6*i));
+	}
+
+	//update local bounding box
+	UpdateBoundBox();
+
+	return bOK;
+}
+
+bool CSPrimCSG::Write2XML(TiXmlElement &elem, bool parameterised)
+{
+	CSPrimitives::Write2XML(elem,parameterised);
+
+	elem.SetAttribute("Operation",GetOperationName().c_str());
+	TiXmlElement Primitives("Primitives");
+	for (size_t i=0;i<m_Primitives.size();++i)
+	{
+		TiXmlElement PrimElem(m_Primitives.at(i)->GetTypeName().c_str());
+		m_Primitives.at(i)->Write2XML(PrimElem,parameterised);
+		Primitives.InsertEndChild(PrimElem);
+	}
+	elem.InsertEndChild(Primitives);
+	return true;
+}
+
+bool CSPrimCSG::ReadFromXML(TiXmlNode &root)
+{
+	if (CSPrimitives::ReadFromXML(root)==false) return false;
+
+	TiXmlElement *elem = root.ToElement();
+	if (elem==NULL) return false;
+	const char* op = elem->Attribute("Operation");
+	if (op==NULL) return false;
+	if (strcmp(op,"Union")==0) m_Operation = UNION;
+	else if (strcmp(op,"Intersection")==0) m_Operation = INTERSECTION;
+	else if (strcmp(op,"Difference")==0) m_Operation = DIFFERENCE;
+	else
+	{
+		cerr << __func__ << ": Error, unknown boolean operation: " << op << endl;
+		return false;
+	}
+
+	ClearPrimitives();
+	TiXmlElement* Primitives = root.FirstChildElement("Primitives");
+	if (Primitives==NULL) return false;
+	TiXmlElement* PrimNode = Primitives->FirstChildElement();
+	while (PrimNode!=NULL)
+	{
+		CSPrimitives* prim = ContinuousStructure::CreatePrimitive(PrimNode->Value(),clParaSet,NULL);
+		if (prim==NULL)
+		{
+			cerr << __func__ << ": Error, unknown primitive: " << PrimNode->Value() << endl;
+			return false;
+		}
+		if (prim->ReadFromXML(*PrimNode)==false)
+		{
+			delete prim;
+			return false;
+		}
+		AddPrimitive(prim);
+		PrimNode=PrimNode->NextSiblingElement();
+	}
+	return (m_Primitives.size()>0);
+}
+
+void CSPrimCSG::ShowPrimitiveStatus(ostream& stream)
+{
+	CSPrimitives::ShowPrimitiveStatus(stream);
+	stream << "  Operation: " << GetOperationName() << endl;
+	for (size_t i=0;i<m_Primitives.size();++i)
+		stream << "  Primitive #" << i << ": " << m_Primitives.at(i)->GetTypeName() << endl;
+}
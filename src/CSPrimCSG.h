@@ -0,0 +1,77 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "CSPrimitives.h"
+
+//! CSG Primitive
+/*!
+ This primitive combines other primitives by a boolean operation: the union or the intersection of all primitives, or the difference of the first primitive and all others.
+ IsInside skips all primitives whose bounding box does not contain the given coordinate.
+ The combined primitives are defined in cartesian coordinates and are owned by this primitive, they do not belong to any property.
+ */
+class CSXCAD_EXPORT CSPrimCSG : public CSPrimitives
+{
+public:
+	enum CSGOperation
+	{
+		UNION, INTERSECTION, DIFFERENCE
+	};
+
+	CSPrimCSG(ParameterSet* paraSet, CSProperties* prop);
+	CSPrimCSG(CSPrimCSG* csg, CSProperties *prop=NULL);
+	CSPrimCSG(unsigned int ID, ParameterSet* paraSet, CSProperties* prop);
+	virtual ~CSPrimCSG();
+
+	virtual CSPrimitives* GetCopy(CSProperties *prop=NULL) {return new CSPrimCSG(this,prop);}
+
+	void SetOperation(CSGOperation op) {m_Operation=op;}
+	CSGOperation GetOperation() const {return m_Operation;}
+	//! Get the name of the boolean operation as used in the xml file, e.g. "Difference".
+	string GetOperationName() const;
+
+	//! Add a primitive to combine, this primitive takes the ownership. The primitive must not belong to any property.
+	void AddPrimitive(CSPrimitives* prim);
+	size_t GetQtyPrimitives() const {return m_Primitives.size();}
+	CSPrimitives* GetPrimitive(size_t index) const;
+	//! Remove and delete all combined primitives.
+	void ClearPrimitives();
+
+	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
+	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
+
+	virtual bool Update(string *ErrStr=NULL);
+	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
+	virtual bool ReadFromXML(TiXmlNode &root);
+
+	virtual void ShowPrimitiveStatus(ostream& stream);
+
+protected:
+	CSGOperation m_Operation;
+	vector<CSPrimitives*> m_Primitives;
+
+	//! Conservative (cartesian) bounding boxes of all combined primitives, only valid if the corresponding m_BoxValid is true.
+	vector<double> m_Boxes;
+	vector<bool> m_BoxValid;
+
+	//! Check if the given (cartesian) position is inside the combined primitive at the given index.
+	bool IsInsidePrimitive(size_t index, const double pos[3], double tol);
+	//! Check if the given (cartesian) position can not be inside the combined primitive at the given index.
+	bool IsOutsideBox(size_t index, const double pos[3]) const;
+};
@@ -119,6 +119,39 @@ bool CSPrimCurve::IsInside(const double* /*Coord*/, double /*tol*/)
 	return false;
 }
 
+double CSPrimCurve::GetCurveDistance(const double pos[3])
+{
+	double min_dist = -1;
+	double foot,dist;
+	for (size_t i=0;i<GetNumberOfPoints();++i)
+	{
+		const double* p0 = points.at(i)->GetCartesianCoords();
+		dist = sqrt(pow(pos[0]-p0[0],2)+pow(pos[1]-p0[1],2)+pow(pos[2]-p0[2],2));
+		if ((min_dist<0) || (dist<min_dist))
+			min_dist = dist;
+		if (i<GetNumberOfPoints()-1)
+		{
+			const double* p1 = points.at(i+1)->GetCartesianCoords();
+			Point_Line_Distance(pos ,p0 ,p1 ,foot ,dist);
+			if ((foot>0) && (foot<1) && (dist<min_dist))
+				min_dist = dist;
+		}
+	}
+	return min_dist;
+}
+
+bool CSPrimCurve::GetSignedDistance(const double* Coord, double &dist)
+{
+	if ((Coord==NULL) || (GetNumberOfPoints()==0)) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+	dist = GetCurveDistance(pos)*GetTransformDistanceScale();
+	return true;
+}
+
 
 bool CSPrimCurve::Update(string *ErrStr)
 {
@@ -137,7 +170,7 @@ bool CSPrimCurve::Update(string *ErrStr)
 	}
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
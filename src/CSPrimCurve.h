@@ -43,6 +43,7 @@ public:
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
@@ -50,4 +51,7 @@ public:
 
 protected:
 	vector<ParameterCoord*> points;
+
+	//! Get the distance of the given (untransformed cartesian) position to the polygonal chain.
+	double GetCurveDistance(const double pos[3]);
 };
@@ -31,6 +31,10 @@ CSPrimCylinder::CSPrimCylinder(unsigned int ID, ParameterSet* paraSet, CSPropert
 	m_AxisCoords[0].SetParameterSet(paraSet);
 	m_AxisCoords[1].SetParameterSet(paraSet);
 	psRadius.SetParameterSet(paraSet);
+	for (int n=0;n<3;++n)
+		m_AxisDir[n] = 0;
+	m_AxisLength = 0;
+	m_RadiusSq = -1;
 	PrimTypeName = string("Cylinder");
 }
 
@@ -40,6 +44,10 @@ CSPrimCylinder::CSPrimCylinder(CSPrimCylinder* cylinder, CSProperties *prop) : C
 	m_AxisCoords[0].Copy(&cylinder->m_AxisCoords[0]);
 	m_AxisCoords[1].Copy(&cylinder->m_AxisCoords[1]);
 	psRadius.Copy(&cylinder->psRadius);
+	for (int n=0;n<3;++n)
+		m_AxisDir[n] = cylinder->m_AxisDir[n];
+	m_AxisLength = cylinder->m_AxisLength;
+	m_RadiusSq = cylinder->m_RadiusSq;
 	PrimTypeName = string("Cylinder");
 }
 
@@ -49,6 +57,10 @@ CSPrimCylinder::CSPrimCylinder(ParameterSet* paraSet, CSProperties* prop) : CSPr
 	m_AxisCoords[0].SetParameterSet(paraSet);
 	m_AxisCoords[1].SetParameterSet(paraSet);
 	psRadius.SetParameterSet(paraSet);
+	for (int n=0;n<3;++n)
+		m_AxisDir[n] = 0;
+	m_AxisLength = 0;
+	m_RadiusSq = -1;
 	PrimTypeName = string("Cylinder");
 }
 
@@ -111,12 +123,18 @@ bool CSPrimCylinder::GetBoundBox(double dBoundBox[6], bool PreserveOrientation)
 	return accurate;
 }
 
+void CSPrimCylinder::GetAxisDistance(const double pos[3], double &axial, double &radial2) const
+{
+	const double* start=m_AxisCoords[0].GetCartesianCoords();
+	double v[3] = {pos[0]-start[0],pos[1]-start[1],pos[2]-start[2]};
+	axial = v[0]*m_AxisDir[0]+v[1]*m_AxisDir[1]+v[2]*m_AxisDir[2];
+	radial2 = v[0]*v[0]+v[1]*v[1]+v[2]*v[2]-axial*axial;
+}
+
 bool CSPrimCylinder::IsInside(const double* Coord, double /*tol*/)
 {
 	if (Coord==NULL) return false;
 
-	const double* start=m_AxisCoords[0].GetCartesianCoords();
-	const double* stop =m_AxisCoords[1].GetCartesianCoords();
 	double pos[3];
 	//transform incoming coordinates into cartesian coords
 	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
@@ -127,14 +145,44 @@ bool CSPrimCylinder::IsInside(const double* Coord, double /*tol*/)
 		if (pos[n]<m_BoundBox[2*n] || pos[n]>m_BoundBox[2*n+1])
 			return false;
 
-	double foot,dist;
-	Point_Line_Distance(pos,start,stop,foot,dist);
-
-	if ((foot<0) || (foot>1)) //the foot point is not on the axis
-		return false;
-	if (dist>psRadius.GetValue())
+	double axial,radial2;
+	GetAxisDistance(pos,axial,radial2);
+	if ((axial<0) || (axial>m_AxisLength)) //the foot point is not on the axis
 		return false;
+	return (radial2<=m_RadiusSq);
+}
 
+void CSPrimCylinder::IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol)
+{
+	if ((m_MeshType!=CARTESIAN) || m_Transform)
+		return CSPrimitives::IsInsideBatch(num,x,y,z,inside,tol);
+	const double* start=m_AxisCoords[0].GetCartesianCoords();
+	const double sx=start[0], sy=start[1], sz=start[2];
+	const double ux=m_AxisDir[0], uy=m_AxisDir[1], uz=m_AxisDir[2];
+	const double len=m_AxisLength, r2=m_RadiusSq;
+	// no branches inside the loop, to allow auto-vectorization
+	for (size_t i=0;i<num;++i)
+	{
+		double vx=x[i]-sx, vy=y[i]-sy, vz=z[i]-sz;
+		double axial = vx*ux+vy*uy+vz*uz;
+		double radial2 = vx*vx+vy*vy+vz*vz-axial*axial;
+		inside[i] = (axial>=0) & (axial<=len) & (radial2<=r2);
+	}
+}
+
+bool CSPrimCylinder::GetSignedDistance(const double* Coord, double &dist)
+{
+	if (Coord==NULL) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+
+	double axial,radial2;
+	GetAxisDistance(pos,axial,radial2);
+	double r = sqrt(max(radial2,0.0));
+	dist = Orthogonal_Distance(r-psRadius.GetValue(),max(-axial,axial-m_AxisLength))*GetTransformDistanceScale();
 	return true;
 }
 
@@ -163,8 +211,22 @@ bool CSPrimCylinder::Update(string *ErrStr)
 		PSErrorCode2Msg(EC,ErrStr);
 	}
 
+	const double* start=m_AxisCoords[0].GetCartesianCoords();
+	const double* stop =m_AxisCoords[1].GetCartesianCoords();
+	m_AxisLength = 0;
+	for (int n=0;n<3;++n)
+	{
+		m_AxisDir[n] = stop[n]-start[n];
+		m_AxisLength += m_AxisDir[n]*m_AxisDir[n];
+	}
+	m_AxisLength = sqrt(m_AxisLength);
+	for (int n=0;n<3;++n)
+		m_AxisDir[n] = (m_AxisLength>0) ? m_AxisDir[n]/m_AxisLength : 0;
+	double radius = psRadius.GetValue();
+	m_RadiusSq = (radius>=0) ? radius*radius : -1;
+
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -48,9 +48,17 @@ public:
 
 	double GetRadius() {return psRadius.GetValue();}
 	ParameterScalar* GetRadiusPS() {return &psRadius;}
+	//! Get the squared radius, -1 for an empty cylinder. Updated by Update().
+	double GetRadiusSq() const {return m_RadiusSq;}
+
+	//! Get the unit vector and the length of the axis. Updated by Update().
+	const double* GetAxisDir() const {return m_AxisDir;}
+	double GetAxisLength() const {return m_AxisLength;}
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual void IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
@@ -61,5 +69,14 @@ public:
 protected:
 	ParameterCoord m_AxisCoords[2];
 	ParameterScalar psRadius;
+
+	//! Unit vector and length of the axis, updated by Update().
+	double m_AxisDir[3];
+	double m_AxisLength;
+	//! Squared radius, -1 for an empty cylinder. Updated by Update().
+	double m_RadiusSq;
+
+	//! Get the position along the axis and the squared distance to the axis, for the given (cartesian) position.
+	void GetAxisDistance(const double pos[3], double &axial, double &radial2) const;
 };
 
@@ -30,6 +30,8 @@ CSPrimCylindricalShell::CSPrimCylindricalShell(unsigned int ID, ParameterSet* pa
 	Type=CYLINDRICALSHELL;
 	PrimTypeName = string("CylindricalShell");
 	psShellWidth.SetParameterSet(paraSet);
+	m_InnerRadiusSq = -1;
+	m_OuterRadiusSq = -1;
 }
 
 CSPrimCylindricalShell::CSPrimCylindricalShell(CSPrimCylindricalShell* cylinder, CSProperties *prop) : CSPrimCylinder(cylinder,prop)
@@ -37,6 +39,8 @@ CSPrimCylindricalShell::CSPrimCylindricalShell(CSPrimCylindricalShell* cylinder,
 	Type=CYLINDRICALSHELL;
 	PrimTypeName = string("CylindricalShell");
 	psShellWidth.Copy(&cylinder->psShellWidth);
+	m_InnerRadiusSq = cylinder->m_InnerRadiusSq;
+	m_OuterRadiusSq = cylinder->m_OuterRadiusSq;
 }
 
 CSPrimCylindricalShell::CSPrimCylindricalShell(ParameterSet* paraSet, CSProperties* prop) : CSPrimCylinder(paraSet,prop)
@@ -44,6 +48,8 @@ CSPrimCylindricalShell::CSPrimCylindricalShell(ParameterSet* paraSet, CSProperti
 	Type=CYLINDRICALSHELL;
 	PrimTypeName = string("CylindricalShell");
 	psShellWidth.SetParameterSet(paraSet);
+	m_InnerRadiusSq = -1;
+	m_OuterRadiusSq = -1;
 }
 
 CSPrimCylindricalShell::~CSPrimCylindricalShell()
@@ -107,8 +113,6 @@ bool CSPrimCylindricalShell::GetBoundBox(double dBoundBox[6], bool PreserveOrien
 bool CSPrimCylindricalShell::IsInside(const double* Coord, double /*tol*/)
 {
 	if (Coord==NULL) return false;
-	const double* start=m_AxisCoords[0].GetCartesianCoords();
-	const double* stop =m_AxisCoords[1].GetCartesianCoords();
 	double pos[3];
 	//transform incoming coordinates into cartesian coords
 	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
@@ -119,14 +123,44 @@ bool CSPrimCylindricalShell::IsInside(const double* Coord, double /*tol*/)
 		if (pos[n]<m_BoundBox[2*n] || pos[n]>m_BoundBox[2*n+1])
 			return false;
 
-	double foot,dist;
-	Point_Line_Distance(pos,start,stop,foot,dist);
-
-	if ((foot<0) || (foot>1)) //the foot point is not on the axis
-		return false;
-	if (fabs(dist-psRadius.GetValue())>psShellWidth.GetValue()/2.0)
+	double axial,radial2;
+	GetAxisDistance(pos,axial,radial2);
+	if ((axial<0) || (axial>m_AxisLength)) //the foot point is not on the axis
 		return false;
+	return (radial2>=m_InnerRadiusSq) && (radial2<=m_OuterRadiusSq);
+}
+
+void CSPrimCylindricalShell::IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol)
+{
+	if ((m_MeshType!=CARTESIAN) || m_Transform)
+		return CSPrimitives::IsInsideBatch(num,x,y,z,inside,tol);
+	const double* start=m_AxisCoords[0].GetCartesianCoords();
+	const double sx=start[0], sy=start[1], sz=start[2];
+	const double ux=m_AxisDir[0], uy=m_AxisDir[1], uz=m_AxisDir[2];
+	const double len=m_AxisLength, r2_in=m_InnerRadiusSq, r2_out=m_OuterRadiusSq;
+	// no branches inside the loop, to allow auto-vectorization
+	for (size_t i=0;i<num;++i)
+	{
+		double vx=x[i]-sx, vy=y[i]-sy, vz=z[i]-sz;
+		double axial = vx*ux+vy*uy+vz*uz;
+		double radial2 = vx*vx+vy*vy+vz*vz-axial*axial;
+		inside[i] = (axial>=0) & (axial<=len) & (radial2>=r2_in) & (radial2<=r2_out);
+	}
+}
+
+bool CSPrimCylindricalShell::GetSignedDistance(const double* Coord, double &dist)
+{
+	if (Coord==NULL) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
 
+	double axial,radial2;
+	GetAxisDistance(pos,axial,radial2);
+	double r = sqrt(max(radial2,0.0));
+	dist = Orthogonal_Distance(fabs(r-psRadius.GetValue())-psShellWidth.GetValue()/2.0,max(-axial,axial-m_AxisLength))*GetTransformDistanceScale();
 	return true;
 }
 
@@ -145,9 +179,14 @@ bool CSPrimCylindricalShell::Update(string *ErrStr)
 		ErrStr->append(stream.str());
 		PSErrorCode2Msg(EC,ErrStr);
 	}
+	// |r-R| <= w/2, a negative squared radius never limits the inner and always limits the outer radius
+	double r_in = psRadius.GetValue()-psShellWidth.GetValue()/2.0;
+	double r_out = psRadius.GetValue()+psShellWidth.GetValue()/2.0;
+	m_InnerRadiusSq = (r_in>0) ? r_in*r_in : -1;
+	m_OuterRadiusSq = (r_out>=0) ? r_out*r_out : -1;
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -0,0 +1,432 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include "tinyxml.h"
+#include "stdint.h"
+
+#include "CSPrimInstance.h"
+#include "CSProperties.h"
+#include "CSUseful.h"
+#include "ContinuousStructure.h"
+
+CSPrimInstance::CSPrimInstance(unsigned int ID, ParameterSet* paraSet, CSProperties* prop) : CSPrimitives(ID,paraSet,prop)
+{
+	Type=INSTANCE;
+	m_Prototype = NULL;
+	for (int n=0;n<3;++n)
+	{
+		m_Count[n] = 1;
+		m_Pitch[n].SetParameterSet(paraSet);
+	}
+	m_ProtoBoxValid = false;
+	for (int n=0;n<6;++n)
+		m_ProtoBox[n]=0;
+	m_OffsetSortDir = 0;
+	PrimTypeName = string("Instance");
+}
+
+CSPrimInstance::CSPrimInstance(CSPrimInstance* instance, CSProperties *prop) : CSPrimitives(instance,prop)
+{
+	Type=INSTANCE;
+	m_Prototype = NULL;
+	if (instance->m_Prototype)
+		m_Prototype = instance->m_Prototype->GetCopy();
+	for (int n=0;n<3;++n)
+	{
+		m_Count[n] = instance->m_Count[n];
+		m_Pitch[n].Copy(&instance->m_Pitch[n]);
+	}
+	m_Offsets = instance->m_Offsets;
+	m_ProtoBoxValid = false;
+	for (int n=0;n<6;++n)
+		m_ProtoBox[n]=0;
+	m_OffsetSortDir = 0;
+	PrimTypeName = string("Instance");
+}
+
+CSPrimInstance::CSPrimInstance(ParameterSet* paraSet, CSProperties* prop) : CSPrimitives(paraSet,prop)
+{
+	Type=INSTANCE;
+	m_Prototype = NULL;
+	for (int n=0;n<3;++n)
+	{
+		m_Count[n] = 1;
+		m_Pitch[n].SetParameterSet(paraSet);
+	}
+	m_ProtoBoxValid = false;
+	for (int n=0;n<6;++n)
+		m_ProtoBox[n]=0;
+	m_OffsetSortDir = 0;
+	PrimTypeName = string("Instance");
+}
+
+CSPrimInstance::~CSPrimInstance()
+{
+	delete m_Prototype;
+	m_Prototype = NULL;
+}
+
+void CSPrimInstance::SetPrototype(CSPrimitives* prim)
+{
+	if (prim==m_Prototype)
+		return;
+	delete m_Prototype;
+	m_Prototype = prim;
+	m_ProtoBoxValid = false;
+}
+
+void CSPrimInstance::AddOffset(double x, double y, double z)
+{
+	m_Offsets.push_back(x);
+	m_Offsets.push_back(y);
+	m_Offsets.push_back(z);
+	m_OffsetOrder.clear();
+}
+
+//! Offsets lists up to this length are searched linearly.
+#define CSPRIMINSTANCE_LINEAR_OFFSETS 16
+
+//! Compare two offsets by their key, used to sort the offsets. \sa CSPrimInstance::SortOffsets
+struct CSOffsetKeyLess
+{
+	const vector<double>* offsets;
+	int dir;
+	bool operator()(size_t a, size_t b) const {return offsets->at(3*a+dir)<offsets->at(3*b+dir);}
+};
+
+void CSPrimInstance::SortOffsets()
+{
+	m_OffsetOrder.clear();
+	m_OffsetKeys.clear();
+	size_t qty = GetQtyOffsets();
+	if ((qty<=CSPRIMINSTANCE_LINEAR_OFFSETS) || (m_ProtoBoxValid==false))
+		return;
+
+	// sort along the direction of the largest spread
+	double spread[3];
+	for (int n=0;n<3;++n)
+	{
+		double lo = m_Offsets.at(n), hi = m_Offsets.at(n);
+		for (size_t i=1;i<qty;++i)
+		{
+			lo = min(lo, m_Offsets.at(3*i+n));
+			hi = max(hi, m_Offsets.at(3*i+n));
+		}
+		spread[n] = hi-lo;
+	}
+	m_OffsetSortDir = 0;
+	for (int n=1;n<3;++n)
+		if (spread[n]>spread[m_OffsetSortDir])
+			m_OffsetSortDir = n;
+
+	m_OffsetOrder.resize(qty);
+	for (size_t i=0;i<qty;++i)
+		m_OffsetOrder[i] = i;
+	CSOffsetKeyLess less;
+	less.offsets = &m_Offsets;
+	less.dir = m_OffsetSortDir;
+	sort(m_OffsetOrder.begin(), m_OffsetOrder.end(), less);
+	m_OffsetKeys.resize(qty);
+	for (size_t i=0;i<qty;++i)
+		m_OffsetKeys[i] = m_Offsets.at(3*m_OffsetOrder[i]+m_OffsetSortDir);
+}
+
+size_t CSPrimInstance::GetQtyInstances() const
+{
+	if (m_Offsets.size()>0)
+		return GetQtyOffsets();
+	return (size_t)m_Count[0]*m_Count[1]*m_Count[2];
+}
+
+bool CSPrimInstance::GetBoundBox(double dBoundBox[6], bool PreserveOrientation)
+{
+	UNUSED(PreserveOrientation); //has no orientation or preserved anyways
+	m_BoundBox_CoordSys=CARTESIAN;
+	m_Dimension=0;
+	for (int n=0;n<6;++n)
+		dBoundBox[n]=0;
+	if ((m_Prototype==NULL) || (GetQtyInstances()==0))
+		return false;
+
+	// range of all instance shifts
+	double shift[6] = {0,0,0,0,0,0};
+	if (m_Offsets.size()>0)
+	{
+		for (int n=0;n<3;++n)
+		{
+			shift[2*n] = m_Offsets.at(n);
+			shift[2*n+1] = m_Offsets.at(n);
+		}
+		for (size_t i=1;i<GetQtyOffsets();++i)
+			for (int n=0;n<3;++n)
+			{
+				shift[2*n] = min(shift[2*n], m_Offsets.at(3*i+n));
+				shift[2*n+1] = max(shift[2*n+1], m_Offsets.at(3*i+n));
+			}
+	}
+	else
+	{
+		for (int n=0;n<3;++n)
+		{
+			double len = (m_Count[n]-1)*m_Pitch[n].GetValue();
+			shift[2*n] = min(0.0,len);
+			shift[2*n+1] = max(0.0,len);
+		}
+	}
+	for (int n=0;n<6;++n)
+		dBoundBox[n] = m_ProtoBox[n] + shift[n];
+	m_Dimension = m_Prototype->GetDimension();
+	return m_ProtoBoxValid;
+}
+
+bool CSPrimInstance::IsInsidePrototype(const double pos[3], const double shift[3], double tol)
+{
+	double local[3];
+	for (int n=0;n<3;++n)
+	{
+		local[n] = pos[n]-shift[n];
+		// fast rejection without calling the prototype
+		if (m_ProtoBoxValid && ((local[n]<m_ProtoBox[2*n]) || (local[n]>m_ProtoBox[2*n+1])))
+			return false;
+	}
+	return m_Prototype->IsInside(local,tol);
+}
+
+bool CSPrimInstance::IsInside(const double* Coord, double tol)
+{
+	if ((Coord==NULL) || (m_Prototype==NULL)) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+
+	if (m_Offsets.size()>0)
+	{
+		if ((m_OffsetOrder.size()==0) || (m_ProtoBoxValid==false))
+		{
+			for (size_t i=0;i<GetQtyOffsets();++i)
+				if (IsInsidePrototype(pos,&m_Offsets.at(3*i),tol))
+					return true;
+			return false;
+		}
+		// only offsets with pos-offset inside the prototype bounding box (in the sorted direction) have to be tested
+		int dir = m_OffsetSortDir;
+		double margin = (m_ProtoBox[2*dir+1]-m_ProtoBox[2*dir]+fabs(pos[dir]))*1e-9;
+		vector<double>::iterator first = lower_bound(m_OffsetKeys.begin(), m_OffsetKeys.end(), pos[dir]-m_ProtoBox[2*dir+1]-margin);
+		vector<double>::iterator last = upper_bound(first, m_OffsetKeys.end(), pos[dir]-m_ProtoBox[2*dir]+margin);
+		for (size_t i=first-m_OffsetKeys.begin();i<(size_t)(last-m_OffsetKeys.begin());++i)
+			if (IsInsidePrototype(pos,&m_Offsets.at(3*m_OffsetOrder[i]),tol))
+				return true;
+		return false;
+	}
+
+	// find the range of lattice positions with a prototype bounding box containing the given position
+	double pitch[3];
+	unsigned int start[3], stop[3];
+	for (int n=0;n<3;++n)
+	{
+		if (m_Count[n]==0)
+			return false;
+		pitch[n] = m_Pitch[n].GetValue();
+		start[n] = 0;
+		stop[n] = m_Count[n]-1;
+		if ((m_ProtoBoxValid==false) || (m_Count[n]==1) || (pitch[n]==0))
+			continue;
+		double margin = fabs(pitch[n])*1e-9;
+		double k1 = (pos[n]-m_ProtoBox[2*n+1]-margin)/pitch[n];
+		double k2 = (pos[n]-m_ProtoBox[2*n]+margin)/pitch[n];
+		double k_min = max(ceil(min(k1,k2)), 0.0);
+		double k_max = min(floor(max(k1,k2)), (double)stop[n]);
+		if (k_min>k_max)
+			return false;
+		start[n] = (unsigned int)k_min;
+		stop[n] = (unsigned int)k_max;
+	}
+
+	unsigned int k[3];
+	double shift[3];
+	for (k[2]=start[2];k[2]<=stop[2];++k[2])
+		for (k[1]=start[1];k[1]<=stop[1];++k[1])
+			for (k[0]=start[0];k[0]<=stop[0];++k[0])
+			{
+				for (int n=0;n<3;++n)
+					shift[n] = k[n]*pitch[n];
+				if (IsInsidePrototype(pos,shift,tol))
+					return true;
+			}
+	return false;
+}
+
+bool CSPrimInstance::Update(string *ErrStr)
+{
+	int EC=0;
+	bool bOK=true;
+	for (int n=0;n<3;++n)
+	{
+		EC=m_Pitch[n].Evaluate();
+		if (EC!=ParameterScalar::NO_ERROR) bOK=false;
+		if ((EC!=ParameterScalar::NO_ERROR)  && (ErrStr!=NULL))
+		{
+			stringstream stream;
+			stream << endl << "Error in " << PrimTypeName << " Pitch (ID: " << uiID << "): ";
+			ErrStr->append(stream.str());
+			PSErrorCode2Msg(EC,ErrStr);
+		}
+	}
+	if ((m_Offsets.size()%3)!=0)
+	{
+		bOK=false;
+		if (ErrStr!=NULL)
+		{
+			stringstream stream;
+			stream << endl << "Error in " << PrimTypeName << " Offsets (ID: " << uiID << "): number of values is not a multiple of 3";
+			ErrStr->append(stream.str());
+		}
+	}
+
+	m_ProtoBoxValid = false;
+	if (m_Prototype==NULL)
+	{
+		bOK=false;
+		if (ErrStr!=NULL)
+		{
+			stringstream stream;
+			stream << endl << "Error in " << PrimTypeName << " (ID: " << uiID << "): no prototype primitive defined";
+			ErrStr->append(stream.str());
+		}
+	}
+	else
+	{
+		// the prototype is always evaluated in cartesian coordinates, see IsInside
+		m_Prototype->SetCoordInputType(CARTESIAN,false);
+		if (m_Prototype->Update(ErrStr)==false)
+			bOK=false;
+
+		m_ProtoBoxValid = m_Prototype->GetTransformedBoundBox(m_ProtoBox);
+	}
+	if ((m_Offsets.size()%3)==0)
+		SortOffsets();
+	else
+		m_OffsetOrder.clear();
+
+	//update local bounding box
+	UpdateBoundBox();
+
+	return bOK;
+}
+
+bool CSPrimInstance::Write2XML(TiXmlElement &elem, bool parameterised)
+{
+	CSPrimitives::Write2XML(elem,parameterised);
+
+	if (m_Prototype)
+	{
+		TiXmlElement Prototype("Prototype");
+		TiXmlElement PrimElem(m_Prototype->GetTypeName().c_str());
+		m_Prototype->Write2XML(PrimElem,parameterised);
+		Prototype.InsertEndChild(PrimElem);
+		elem.InsertEndChild(Prototype);
+	}
+
+	if (m_Offsets.size()>0)
+	{
+		TiXmlElement Offsets("Offsets");
+		TiXmlText text(CombineVector2String(m_Offsets,','));
+		Offsets.InsertEndChild(text);
+		elem.InsertEndChild(Offsets);
+		return true;
+	}
+
+	TiXmlElement Lattice("Lattice");
+	int count[3] = {(int)m_Count[0],(int)m_Count[1],(int)m_Count[2]};
+	Lattice.SetAttribute("Count",CombineArray2String(count,3,','));
+	WriteTerm(m_Pitch[0],Lattice,"PitchX",parameterised);
+	WriteTerm(m_Pitch[1],Lattice,"PitchY",parameterised);
+	WriteTerm(m_Pitch[2],Lattice,"PitchZ",parameterised);
+	elem.InsertEndChild(Lattice);
+	return true;
+}
+
+bool CSPrimInstance::ReadFromXML(TiXmlNode &root)
+{
+	if (CSPrimitives::ReadFromXML(root)==false) return false;
+
+	TiXmlElement* Prototype = root.FirstChildElement("Prototype");
+	if (Prototype==NULL) return false;
+	TiXmlElement* PrimNode = Prototype->FirstChildElement();
+	if (PrimNode==NULL) return false;
+	CSPrimitives* prim = ContinuousStructure::CreatePrimitive(PrimNode->Value(),clParaSet,NULL);
+	if (prim==NULL)
+	{
+		cerr << __func__ << ": Error, unknown prototype primitive: " << PrimNode->Value() << endl;
+		return false;
+	}
+	if (prim->ReadFromXML(*PrimNode)==false)
+	{
+		delete prim;
+		return false;
+	}
+	SetPrototype(prim);
+
+	ClearOffsets();
+	TiXmlElement* Offsets = root.FirstChildElement("Offsets");
+	if (Offsets)
+	{
+		TiXmlNode* FN = Offsets->FirstChild();
+		if ((FN==NULL) || (FN->ToText()==NULL))
+			return false;
+		m_Offsets = SplitString2Double(FN->ToText()->Value(),',');
+		return (m_Offsets.size()%3)==0;
+	}
+
+	TiXmlElement* Lattice = root.FirstChildElement("Lattice");
+	if (Lattice==NULL) return false;
+	const char* count = Lattice->Attribute("Count");
+	int values[3];
+	if ((count==NULL) || (SplitString2Int(count,',',values,3)!=3))
+		return false;
+	for (int n=0;n<3;++n)
+	{
+		if (values[n]<0)
+			return false;
+		m_Count[n] = values[n];
+	}
+	if (ReadTerm(m_Pitch[0],*Lattice,"PitchX")==false) return false;
+	if (ReadTerm(m_Pitch[1],*Lattice,"PitchY")==false) return false;
+	if (ReadTerm(m_Pitch[2],*Lattice,"PitchZ")==false) return false;
+
+	return true;
+}
+
+void CSPrimInstance::ShowPrimitiveStatus(ostream& stream)
+{
+	CSPrimitives::ShowPrimitiveStatus(stream);
+	if (m_Prototype)
+		stream << "  Prototype: " << m_Prototype->GetTypeName() << endl;
+	if (m_Offsets.size()>0)
+		stream << "  Instances: " << GetQtyOffsets() << " (explicit offsets)" << endl;
+	else
+	{
+		stream << "  Lattice Count: " << m_Count[0] << "," << m_Count[1] << "," << m_Count[2] << endl;
+		stream << "  Lattice Pitch: " << m_Pitch[0].GetValueString() << "," << m_Pitch[1].GetValueString() << "," << m_Pitch[2].GetValueString() << endl;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "CSPrimitives.h"
+
+//! Instance Primitive
+/*!
+ This primitive places many copies of a single prototype primitive, without duplicating its geometry.
+ The copies are either placed on a regular lattice (count and pitch in each direction) or at an explicit list of offsets.
+ IsInside maps a coordinate into the frame of the prototype, for a regular lattice only the (few) nearest lattice positions are tested.
+ A long list of offsets is sorted along its widest direction by Update, only offsets in range of the prototype bounding box are tested.
+ The prototype is defined in cartesian coordinates and is owned by this primitive, it does not belong to any property.
+ */
+class CSXCAD_EXPORT CSPrimInstance : public CSPrimitives
+{
+public:
+	CSPrimInstance(ParameterSet* paraSet, CSProperties* prop);
+	CSPrimInstance(CSPrimInstance* instance, CSProperties *prop=NULL);
+	CSPrimInstance(unsigned int ID, ParameterSet* paraSet, CSProperties* prop);
+	virtual ~CSPrimInstance();
+
+	virtual CSPrimitives* GetCopy(CSProperties *prop=NULL) {return new CSPrimInstance(this,prop);}
+
+	//! Set the prototype primitive, this primitive takes the ownership. The prototype must not belong to any property.
+	void SetPrototype(CSPrimitives* prim);
+	CSPrimitives* GetPrototype() const {return m_Prototype;}
+
+	//! Set the number of lattice positions in the given direction. \sa SetLatticePitch
+	void SetLatticeCount(int ny, unsigned int count) {if ((ny>=0) && (ny<3)) m_Count[ny]=count;}
+	unsigned int GetLatticeCount(int ny) const {if ((ny>=0) && (ny<3)) return m_Count[ny]; return 0;}
+	//! Set the distance of the lattice positions in the given direction. \sa SetLatticeCount
+	void SetLatticePitch(int ny, double val) {if ((ny>=0) && (ny<3)) m_Pitch[ny].SetValue(val);}
+	void SetLatticePitch(int ny, const char* val) {if ((ny>=0) && (ny<3)) m_Pitch[ny].SetValue(val);}
+	double GetLatticePitch(int ny) {if ((ny>=0) && (ny<3)) return m_Pitch[ny].GetValue(); return 0;}
+	ParameterScalar* GetLatticePitchPS(int ny) {if ((ny>=0) && (ny<3)) return &m_Pitch[ny]; return NULL;}
+
+	//! Add an explicit instance offset. If any offset is defined, the regular lattice is not used.
+	void AddOffset(double x, double y, double z);
+	void ClearOffsets() {m_Offsets.clear(); m_OffsetOrder.clear();}
+	size_t GetQtyOffsets() const {return m_Offsets.size()/3;}
+	//! Get all instance offsets (x,y,z for every instance).
+	const vector<double>& GetOffsets() const {return m_Offsets;}
+
+	//! Get the total number of instances.
+	size_t GetQtyInstances() const;
+
+	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
+	virtual bool IsInside(const double* Coord, double tol=0);
+
+	virtual bool Update(string *ErrStr=NULL);
+	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
+	virtual bool ReadFromXML(TiXmlNode &root);
+
+	virtual void ShowPrimitiveStatus(ostream& stream);
+
+protected:
+	CSPrimitives* m_Prototype;
+	unsigned int m_Count[3];
+	ParameterScalar m_Pitch[3];
+	vector<double> m_Offsets;
+
+	//! Conservative (cartesian) bounding box of the prototype, including its transformation. Only valid if m_ProtoBoxValid is true.
+	double m_ProtoBox[6];
+	bool m_ProtoBoxValid;
+
+	//! Offsets sorted along the direction m_OffsetSortDir, empty if not sorted. \sa SortOffsets
+	vector<size_t> m_OffsetOrder;
+	vector<double> m_OffsetKeys;
+	int m_OffsetSortDir;
+	//! Sort a long list of offsets, requires a valid prototype bounding box.
+	void SortOffsets();
+
+	//! Check if the given (cartesian) position is inside the prototype shifted by the given offset.
+	bool IsInsidePrototype(const double pos[3], const double shift[3], double tol);
+};
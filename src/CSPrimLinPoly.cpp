@@ -87,6 +87,24 @@ bool CSPrimLinPoly::IsInside(const double* Coord, double tol)
 	return CSPrimPolygon::IsInside(coords, tol);
 }
 
+bool CSPrimLinPoly::GetSignedDistance(const double* inCoord, double &dist)
+{
+	if ((inCoord==NULL) || (vCoords.size()<2)) return false;
+
+	double Coord[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(inCoord,Coord,m_MeshType,CARTESIAN);
+	if (m_Transform && Type==LINPOLY)
+		TransformCoords(Coord,true, CARTESIAN);
+
+	double elevation = Elevation.GetValue();
+	double len = extrudeLength.GetValue();
+	double plane_dist = GetPolygonDistance(Coord[(m_NormDir+1)%3],Coord[(m_NormDir+2)%3]);
+	double axial = max(min(elevation,elevation+len)-Coord[m_NormDir], Coord[m_NormDir]-max(elevation,elevation+len));
+	dist = Orthogonal_Distance(plane_dist,axial)*GetTransformDistanceScale();
+	return true;
+}
+
 
 bool CSPrimLinPoly::Update(string *ErrStr)
 {
@@ -106,7 +124,7 @@ bool CSPrimLinPoly::Update(string *ErrStr)
 	}
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -222,7 +222,7 @@ bool CSPrimMultiBox::Update(string *ErrStr)
 		}
 	}
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 	return bOK;
 }
 
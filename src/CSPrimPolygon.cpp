@@ -140,7 +140,7 @@ bool CSPrimPolygon::GetBoundBox(double dBoundBox[6], bool PreserveOrientation)
 bool CSPrimPolygon::IsInside(const double* inCoord, double /*tol*/)
 {
 	if (inCoord==NULL) return false;
-	if (vCoords.size()<2) return false;
+	if (m_VertexCoords.size()<2) return false;
 
 	double Coord[3];
 	//transform incoming coordinates into cartesian coords
@@ -157,20 +157,26 @@ bool CSPrimPolygon::IsInside(const double* inCoord, double /*tol*/)
 	x = Coord[nP];
 	y = Coord[nPP];
 
+	return IsInsidePolygon(m_VertexCoords.size()/2,&m_VertexCoords[0],x,y);
+}
+
+bool CSPrimPolygon::IsInsidePolygon(size_t np, const double* coords, double x, double y)
+{
+	if (np==0)
+		return false;
+
 	int wn = 0;
 
-	size_t np = vCoords.size()/2;
-	double x1 = vCoords[2*np-2].GetValue();
-	double y1 = vCoords[2*np-1].GetValue();
-	double x2 = vCoords[0].GetValue();
-	double y2 = vCoords[1].GetValue();
+	double x1 = coords[2*np-2];
+	double y1 = coords[2*np-1];
+	double x2, y2;
 	bool startover = y1 >= y ? true : false;
 	bool endover;
 
 	for (size_t i=0;i<np;++i)
 	{
-		x2 = vCoords[2*i].GetValue();
-		y2 = vCoords[2*i+1].GetValue();
+		x2 = coords[2*i];
+		y2 = coords[2*i+1];
 
 		//check if coord is on a cartesian edge exactly
 		if ((x2==x1) && (x1==x) && ( ((y<y1) && (y>y2)) || ((y>y1) && (y<y2)) ))
@@ -201,6 +207,56 @@ bool CSPrimPolygon::IsInside(const double* inCoord, double /*tol*/)
 	return false;
 }
 
+double CSPrimPolygon::GetPolygonDistance(double x, double y)
+{
+	size_t np = vCoords.size()/2;
+	double min_dist2 = -1;
+	bool inside = false;
+	double x1 = vCoords[2*np-2].GetValue();
+	double y1 = vCoords[2*np-1].GetValue();
+	for (size_t i=0;i<np;++i)
+	{
+		double x2 = vCoords[2*i].GetValue();
+		double y2 = vCoords[2*i+1].GetValue();
+
+		// squared distance to the edge
+		double dx = x2-x1;
+		double dy = y2-y1;
+		double LL = dx*dx+dy*dy;
+		double foot = 0;
+		if (LL>0)
+			foot = min(1.0,max(0.0,((x-x1)*dx+(y-y1)*dy)/LL));
+		double dist2 = pow(x-x1-foot*dx,2)+pow(y-y1-foot*dy,2);
+		if ((min_dist2<0) || (dist2<min_dist2))
+			min_dist2 = dist2;
+
+		// crossing number
+		if (((y1>y) != (y2>y)) && (x < x1 + (y-y1)*dx/dy))
+			inside = !inside;
+		x1 = x2;
+		y1 = y2;
+	}
+	return inside ? -sqrt(min_dist2) : sqrt(min_dist2);
+}
+
+bool CSPrimPolygon::GetSignedDistance(const double* inCoord, double &dist)
+{
+	// a rotational polygon has to implement its own distance
+	if ((inCoord==NULL) || (vCoords.size()<2) || (Type!=POLYGON)) return false;
+
+	double Coord[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(inCoord,Coord,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		TransformCoords(Coord,true, CARTESIAN);
+
+	// a flat polygon, the distance is never negative
+	double plane_dist = GetPolygonDistance(Coord[(m_NormDir+1)%3],Coord[(m_NormDir+2)%3]);
+	dist = Orthogonal_Distance(max(plane_dist,0.0),fabs(Coord[m_NormDir]-Elevation.GetValue()));
+	dist *= GetTransformDistanceScale();
+	return true;
+}
+
 
 bool CSPrimPolygon::Update(string *ErrStr)
 {
@@ -224,6 +280,9 @@ bool CSPrimPolygon::Update(string *ErrStr)
 			PSErrorCode2Msg(EC,ErrStr);
 		}
 	}
+	m_VertexCoords.resize(vCoords.size());
+	for (size_t i=0;i<vCoords.size();++i)
+		m_VertexCoords[i] = vCoords[i].GetValue();
 
 	EC=Elevation.Evaluate();
 	if (EC!=ParameterScalar::NO_ERROR) bOK=false;
@@ -237,7 +296,7 @@ bool CSPrimPolygon::Update(string *ErrStr)
 	}
 
 	//update local bounding box used to speedup IsInside()
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -61,17 +61,29 @@ public:
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
 	virtual bool ReadFromXML(TiXmlNode &root);
 
+	//! Get the evaluated vertices x1,y1,x2,y2 ... xn,yn, updated by Update().
+	const vector<double>& GetVertexCoords() const {return m_VertexCoords;}
+
+	//! Winding number test of the point (x,y) against a polygon of np vertices given as x1,y1,x2,y2 ... xn,yn, a point exactly on a cartesian edge is inside.
+	static bool IsInsidePolygon(size_t np, const double* coords, double x, double y);
+
 protected:
 	///Vector describing the polygon, x1,y1,x2,y2 ... xn,yn
 	vector<ParameterScalar> vCoords;
+	//! Evaluated vertices of vCoords, updated by Update().
+	vector<double> m_VertexCoords;
 	///The polygon plane normal direction
 	int m_NormDir;
 	///The polygon plane elevation in direction of the normal vector
 	ParameterScalar Elevation;
+
+	//! Get the signed distance of the given point (in the polygon plane) to the polygon outline, negative inside.
+	double GetPolygonDistance(double x, double y);
 };
 
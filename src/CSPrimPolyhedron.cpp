@@ -86,6 +86,7 @@ CSPrimPolyhedron::CSPrimPolyhedron(unsigned int ID, ParameterSet* paraSet, CSPro
 	PrimTypeName = "Polyhedron";
 	d_ptr->m_PolyhedronTree = NULL;
 	m_InvalidFaces = 0;
+	m_DeferTreeBuild = false;
 }
 
 CSPrimPolyhedron::CSPrimPolyhedron(CSPrimPolyhedron* primPolyhedron, CSProperties *prop) : CSPrimitives(primPolyhedron,prop), d_ptr(new CSPrimPolyhedronPrivate)
@@ -94,6 +95,7 @@ CSPrimPolyhedron::CSPrimPolyhedron(CSPrimPolyhedron* primPolyhedron, CSPropertie
 	PrimTypeName = "Polyhedron";
 	d_ptr->m_PolyhedronTree = NULL;
 	m_InvalidFaces = 0;
+	m_DeferTreeBuild = false;
 
 	//copy all vertices
 	for (size_t n=0;n<primPolyhedron->m_Vertices.size();++n)
@@ -109,6 +111,7 @@ CSPrimPolyhedron::CSPrimPolyhedron(ParameterSet* paraSet, CSProperties* prop) :
 	PrimTypeName = "Polyhedron";
 	d_ptr->m_PolyhedronTree = NULL;
 	m_InvalidFaces = 0;
+	m_DeferTreeBuild = false;
 }
 
 CSPrimPolyhedron::~CSPrimPolyhedron()
@@ -127,6 +130,7 @@ void CSPrimPolyhedron::Reset()
 	}
 	m_Faces.clear();
 	d_ptr->m_Polyhedron.clear();
+	delete d_ptr->m_PolyhedronTree;
 	d_ptr->m_PolyhedronTree = NULL;
 	m_InvalidFaces = 0;
 }
@@ -173,6 +177,14 @@ void CSPrimPolyhedron::AddFace(vector<int> vertices)
 }
 
 bool CSPrimPolyhedron::BuildTree()
+{
+	double rnd[3];
+	for (int n=0;n<3;++n)
+		rnd[n] = (double)rand()/RAND_MAX;
+	return BuildTree(rnd);
+}
+
+bool CSPrimPolyhedron::BuildTree(const double rnd[3])
 {
 	Polyhedron_Builder builder(this);
 	d_ptr->m_Polyhedron.delegate(builder);
@@ -195,9 +207,10 @@ bool CSPrimPolyhedron::BuildTree()
 	delete d_ptr->m_PolyhedronTree;
 	d_ptr->m_PolyhedronTree = new CGAL::AABB_tree< Traits >(d_ptr->m_Polyhedron.facets_begin(),d_ptr->m_Polyhedron.facets_end());
 
-	//update local bounding box
+	//update local bounding box, this may run in a worker thread, see ContinuousStructure::BuildPendingTrees
 	GetBoundBox(m_BoundBox);
-	double p[3] = {m_BoundBox[1]*(1.0+(double)rand()/RAND_MAX),m_BoundBox[3]*(1.0+(double)rand()/RAND_MAX),m_BoundBox[5]*(1.0+(double)rand()/RAND_MAX)};
+	++m_UpdateRevision;
+	double p[3] = {m_BoundBox[1]*(1.0+rnd[0]),m_BoundBox[3]*(1.0+rnd[1]),m_BoundBox[5]*(1.0+rnd[2])};
 	d_ptr->m_RandPt = Point(p[0],p[1],p[2]);
 	return true;
 }
@@ -261,11 +274,31 @@ bool CSPrimPolyhedron::IsInside(const double* Coord, double /*tol*/)
 	return false;
 }
 
+bool CSPrimPolyhedron::GetSignedDistance(const double* Coord, double &dist)
+{
+	if ((Coord==NULL) || (d_ptr->m_PolyhedronTree==NULL) || (m_Faces.size()==0))
+		return false;
+
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+
+	// nearest triangle search using the AABB tree
+	Point p(pos[0], pos[1], pos[2]);
+	dist = sqrt(d_ptr->m_PolyhedronTree->squared_distance(p));
+	if (IsInside(Coord))
+		dist = -dist;
+	dist *= GetTransformDistanceScale();
+	return true;
+}
+
 
 bool CSPrimPolyhedron::Update(string *ErrStr)
 {
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 	return CSPrimitives::Update(ErrStr);
 }
 
@@ -298,48 +331,47 @@ bool CSPrimPolyhedron::ReadFromXML(TiXmlNode &root)
 	TiXmlText* Text=NULL;
 
 	// read vertices
-	vector<double> coords;
+	double coords[3];
 	TiXmlElement* vertex = root.FirstChildElement("Vertex");
 	while (vertex)
 	{
-		coords.clear();
 		FN = vertex->FirstChild();
 		if (FN!=NULL)
 		{
 			Text = FN->ToText();
-			if (Text!=NULL)
-				coords = SplitString2Double(string(Text->Value()), ',');
-			else
+			if (Text==NULL)
 				return false;
-			if (coords.size()!=3)
+			if (SplitString2Double(Text->Value(), ',', coords, 3)!=3)
 				return false;
-			AddVertex(coords.at(0),coords.at(1),coords.at(2));
+			AddVertex(coords[0],coords[1],coords[2]);
 		}
 		else
 			return false;
 		vertex = vertex->NextSiblingElement("Vertex");
 	}
 
-	// read faces
-	vector<int> vertices;
+	// read faces, triangles are parsed without any temporary allocation
+	int triangle[3];
 	TiXmlElement* face = root.FirstChildElement("Face");
 	while (face)
 	{
-		coords.clear();
 		FN = face->FirstChild();
 		if (FN!=NULL)
 		{
 			Text = FN->ToText();
-			if (Text!=NULL)
-				vertices = SplitString2Int(string(Text->Value()), ',');
-			else
+			if (Text==NULL)
 				return false;
-			AddFace(vertices);
+			if (SplitString2Int(Text->Value(), ',', triangle, 3)==3)
+				AddFace(3, triangle);
+			else
+				AddFace(SplitString2Int(Text->Value(), ','));
 		}
 		else
 			return false;
 		face = face->NextSiblingElement("Face");
 	}
+	if (m_DeferTreeBuild)
+		return true;
 	return BuildTree();
 }
 
@@ -59,6 +59,12 @@ public:
 	virtual void AddFace(vector<int> vertices);
 
 	virtual bool BuildTree();
+	//! Build the search tree using the given random numbers [0..1] for the ray casting reference point.
+	virtual bool BuildTree(const double rnd[3]);
+
+	//! Skip the search tree build in ReadFromXML, BuildTree has to be called before the polyhedron is used.
+	void SetDeferTreeBuild(bool val) {m_DeferTreeBuild=val;}
+	bool GetDeferTreeBuild() const {return m_DeferTreeBuild;}
 
 	virtual unsigned int GetNumFaces() const {return m_Faces.size();}
 	virtual int* GetFace(unsigned int n, unsigned int &numVertices);
@@ -68,6 +74,7 @@ public:
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
@@ -77,6 +84,7 @@ public:
 
 protected:
 	unsigned int m_InvalidFaces;
+	bool m_DeferTreeBuild;
 	vector<vertex> m_Vertices;
 	vector<face> m_Faces;
 	CSPrimPolyhedronPrivate *d_ptr; //!< pointer to private data structure, to hide the CGAL dependency from applications
@@ -35,6 +35,7 @@ CSPrimPolyhedronReader::CSPrimPolyhedronReader(ParameterSet* paraSet, CSProperti
 	Type = POLYHEDRONREADER;
 	PrimTypeName = "PolyhedronReader";
 	m_filetype = UNKNOWN;
+	m_ReadPending = false;
 }
 
 CSPrimPolyhedronReader::CSPrimPolyhedronReader(CSPrimPolyhedronReader* primPHReader, CSProperties *prop) : CSPrimPolyhedron(primPHReader, prop)
@@ -44,6 +45,7 @@ CSPrimPolyhedronReader::CSPrimPolyhedronReader(CSPrimPolyhedronReader* primPHRea
 
 	m_filename = primPHReader->m_filename;
 	m_filetype = primPHReader->m_filetype;
+	m_ReadPending = primPHReader->m_ReadPending;
 }
 
 CSPrimPolyhedronReader::CSPrimPolyhedronReader(unsigned int ID, ParameterSet* paraSet, CSProperties* prop) : CSPrimPolyhedron(ID, paraSet, prop)
@@ -51,6 +53,7 @@ CSPrimPolyhedronReader::CSPrimPolyhedronReader(unsigned int ID, ParameterSet* pa
 	Type = POLYHEDRONREADER;
 	PrimTypeName = "PolyhedronReader";
 	m_filetype = UNKNOWN;
+	m_ReadPending = false;
 }
 
 CSPrimPolyhedronReader::~CSPrimPolyhedronReader()
@@ -105,15 +108,39 @@ bool CSPrimPolyhedronReader::ReadFromXML(TiXmlNode &root)
 	else
 		m_filetype=UNKNOWN;
 
+	// the geometry was stored in a HDF5 structure file and is read by the structure
+	if (elem->Attribute("HDF5_Geometry"))
+		return true;
+
+	// the file is read together with the deferred search tree build, see ContinuousStructure::BuildPendingTrees
+	if (m_DeferTreeBuild)
+	{
+		m_ReadPending = true;
+		return true;
+	}
+
 	if (ReadFile(m_filename)==false)
 	{
 		cerr << "CSPrimPolyhedronReader::ReadFromXML: Failed to read file." << endl;
 		return false;
 	}
-
 	return BuildTree();
 }
 
+bool CSPrimPolyhedronReader::BuildTree(const double rnd[3])
+{
+	if (m_ReadPending)
+	{
+		m_ReadPending = false;
+		if (ReadFile(m_filename)==false)
+		{
+			cerr << "CSPrimPolyhedronReader::BuildTree: Failed to read file." << endl;
+			return false;
+		}
+	}
+	return CSPrimPolyhedron::BuildTree(rnd);
+}
+
 bool CSPrimPolyhedronReader::ReadFile(string filename)
 {
 	vtkPolyData *polydata = NULL;
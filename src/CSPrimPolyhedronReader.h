@@ -48,7 +48,13 @@ public:
 
 	virtual bool ReadFile(string filename);
 
+	virtual bool BuildTree() {return CSPrimPolyhedron::BuildTree();}
+	//! Build the search tree, the file is read first if ReadFromXML deferred the read. \sa SetDeferTreeBuild
+	virtual bool BuildTree(const double rnd[3]);
+
 protected:
 	string m_filename;
 	FileType m_filetype;
+	//! The file has not been read yet, it is read by BuildTree. \sa ReadFromXML
+	bool m_ReadPending;
 };
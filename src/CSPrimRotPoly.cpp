@@ -148,7 +148,7 @@ bool CSPrimRotPoly::Update(string *ErrStr)
 	}
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -30,6 +30,7 @@ CSPrimSphere::CSPrimSphere(unsigned int ID, ParameterSet* paraSet, CSProperties*
 	Type=SPHERE;
 	m_Center.SetParameterSet(paraSet);
 	psRadius.SetParameterSet(paraSet);
+	m_RadiusSq = -1;
 	PrimTypeName = string("Sphere");
 }
 
@@ -38,6 +39,7 @@ CSPrimSphere::CSPrimSphere(CSPrimSphere* sphere, CSProperties *prop) : CSPrimiti
 	Type=SPHERE;
 	m_Center.Copy(&sphere->m_Center);
 	psRadius.Copy(&sphere->psRadius);
+	m_RadiusSq = sphere->m_RadiusSq;
 	PrimTypeName = string("Sphere");
 }
 
@@ -46,6 +48,7 @@ CSPrimSphere::CSPrimSphere(ParameterSet* paraSet, CSProperties* prop) : CSPrimit
 	Type=SPHERE;
 	m_Center.SetParameterSet(paraSet);
 	psRadius.SetParameterSet(paraSet);
+	m_RadiusSq = -1;
 	PrimTypeName = string("Sphere");
 }
 
@@ -107,10 +110,36 @@ bool CSPrimSphere::IsInside(const double* Coord, double /*tol*/)
 	TransformCoordSystem(Coord,out,m_MeshType,CARTESIAN);
 	if (m_Transform)
 		m_Transform->InvertTransform(out,out);
-	double dist=sqrt(pow(out[0]-center[0],2)+pow(out[1]-center[1],2)+pow(out[2]-center[2],2));
-	if (dist<psRadius.GetValue())
-		return true;
-	return false;
+	double dist2=(out[0]-center[0])*(out[0]-center[0])+(out[1]-center[1])*(out[1]-center[1])+(out[2]-center[2])*(out[2]-center[2]);
+	return (dist2<m_RadiusSq);
+}
+
+void CSPrimSphere::IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol)
+{
+	if ((m_MeshType!=CARTESIAN) || m_Transform)
+		return CSPrimitives::IsInsideBatch(num,x,y,z,inside,tol);
+	const double* center = m_Center.GetCartesianCoords();
+	const double cx=center[0], cy=center[1], cz=center[2];
+	const double r2=m_RadiusSq;
+	// no branches inside the loop, to allow auto-vectorization
+	for (size_t i=0;i<num;++i)
+	{
+		double dx=x[i]-cx, dy=y[i]-cy, dz=z[i]-cz;
+		inside[i] = (dx*dx+dy*dy+dz*dz<r2);
+	}
+}
+
+bool CSPrimSphere::GetSignedDistance(const double* Coord, double &dist)
+{
+	if (Coord==NULL) return false;
+	double out[3];
+	const double* center = m_Center.GetCartesianCoords();
+	TransformCoordSystem(Coord,out,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(out,out);
+	double r=sqrt(pow(out[0]-center[0],2)+pow(out[1]-center[1],2)+pow(out[2]-center[2],2));
+	dist = (r-psRadius.GetValue())*GetTransformDistanceScale();
+	return true;
 }
 
 bool CSPrimSphere::Update(string *ErrStr)
@@ -135,9 +164,11 @@ bool CSPrimSphere::Update(string *ErrStr)
 		ErrStr->append(stream.str());
 		PSErrorCode2Msg(EC,ErrStr);
 	}
+	double radius = psRadius.GetValue();
+	m_RadiusSq = (radius>0) ? radius*radius : -1;
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -55,9 +55,13 @@ public:
 
 	double GetRadius() {return psRadius.GetValue();}
 	ParameterScalar* GetRadiusPS() {return &psRadius;}
+	//! Get the squared radius, -1 for an empty sphere. Updated by Update().
+	double GetRadiusSq() const {return m_RadiusSq;}
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual void IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
@@ -68,5 +72,8 @@ public:
 protected:
 	ParameterCoord m_Center;
 	ParameterScalar psRadius;
+
+	//! Squared radius, -1 for an empty sphere. Updated by Update().
+	double m_RadiusSq;
 };
 
@@ -30,6 +30,8 @@ CSPrimSphericalShell::CSPrimSphericalShell(unsigned int ID, ParameterSet* paraSe
 	Type=SPHERICALSHELL;
 	PrimTypeName = string("SphericalShell");
 	psShellWidth.SetParameterSet(paraSet);
+	m_InnerRadiusSq = -1;
+	m_OuterRadiusSq = -1;
 }
 
 CSPrimSphericalShell::CSPrimSphericalShell(CSPrimSphericalShell* sphere, CSProperties *prop) : CSPrimSphere(sphere,prop)
@@ -37,6 +39,8 @@ CSPrimSphericalShell::CSPrimSphericalShell(CSPrimSphericalShell* sphere, CSPrope
 	Type=SPHERICALSHELL;
 	PrimTypeName = string("SphericalShell");
 	psShellWidth.Copy(&sphere->psShellWidth);
+	m_InnerRadiusSq = sphere->m_InnerRadiusSq;
+	m_OuterRadiusSq = sphere->m_OuterRadiusSq;
 }
 
 CSPrimSphericalShell::CSPrimSphericalShell(ParameterSet* paraSet, CSProperties* prop) : CSPrimSphere(paraSet,prop)
@@ -44,6 +48,8 @@ CSPrimSphericalShell::CSPrimSphericalShell(ParameterSet* paraSet, CSProperties*
 	Type=SPHERICALSHELL;
 	PrimTypeName = string("SphericalShell");
 	psShellWidth.SetParameterSet(paraSet);
+	m_InnerRadiusSq = -1;
+	m_OuterRadiusSq = -1;
 }
 
 
@@ -80,10 +86,37 @@ bool CSPrimSphericalShell::IsInside(const double* Coord, double /*tol*/)
 	TransformCoordSystem(Coord,out,m_MeshType,CARTESIAN);
 	if (m_Transform)
 		m_Transform->InvertTransform(out,out);
-	double dist=sqrt(pow(out[0]-center[0],2)+pow(out[1]-center[1],2)+pow(out[2]-center[2],2));
-	if (fabs(dist-psRadius.GetValue())< psShellWidth.GetValue()/2.0)
-		return true;
-	return false;
+	double dist2=(out[0]-center[0])*(out[0]-center[0])+(out[1]-center[1])*(out[1]-center[1])+(out[2]-center[2])*(out[2]-center[2]);
+	return (dist2>m_InnerRadiusSq) && (dist2<m_OuterRadiusSq);
+}
+
+void CSPrimSphericalShell::IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol)
+{
+	if ((m_MeshType!=CARTESIAN) || m_Transform)
+		return CSPrimitives::IsInsideBatch(num,x,y,z,inside,tol);
+	const double* center = m_Center.GetCartesianCoords();
+	const double cx=center[0], cy=center[1], cz=center[2];
+	const double r2_in=m_InnerRadiusSq, r2_out=m_OuterRadiusSq;
+	// no branches inside the loop, to allow auto-vectorization
+	for (size_t i=0;i<num;++i)
+	{
+		double dx=x[i]-cx, dy=y[i]-cy, dz=z[i]-cz;
+		double dist2 = dx*dx+dy*dy+dz*dz;
+		inside[i] = (dist2>r2_in) & (dist2<r2_out);
+	}
+}
+
+bool CSPrimSphericalShell::GetSignedDistance(const double* Coord, double &dist)
+{
+	if (Coord==NULL) return false;
+	double out[3];
+	const double* center = m_Center.GetCartesianCoords();
+	TransformCoordSystem(Coord,out,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(out,out);
+	double r=sqrt(pow(out[0]-center[0],2)+pow(out[1]-center[1],2)+pow(out[2]-center[2],2));
+	dist = (fabs(r-psRadius.GetValue())-psShellWidth.GetValue()/2.0)*GetTransformDistanceScale();
+	return true;
 }
 
 bool CSPrimSphericalShell::Update(string *ErrStr)
@@ -101,9 +134,14 @@ bool CSPrimSphericalShell::Update(string *ErrStr)
 		ErrStr->append(stream.str());
 		PSErrorCode2Msg(EC,ErrStr);
 	}
+	// |r-R| < w/2, a negative squared radius never limits the inner and always limits the outer radius
+	double r_in = psRadius.GetValue()-psShellWidth.GetValue()/2.0;
+	double r_out = psRadius.GetValue()+psShellWidth.GetValue()/2.0;
+	m_InnerRadiusSq = (r_in>=0) ? r_in*r_in : -1;
+	m_OuterRadiusSq = (r_out>0) ? r_out*r_out : -1;
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
@@ -40,9 +40,14 @@ public:
 
 	double GetShellWidth() {return psShellWidth.GetValue();}
 	ParameterScalar* GetShellWidthPS() {return &psShellWidth;}
+	//! Get the squared inner and outer radius of the shell, -1 if not limiting. Updated by Update().
+	double GetInnerRadiusSq() const {return m_InnerRadiusSq;}
+	double GetOuterRadiusSq() const {return m_OuterRadiusSq;}
 
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false);
 	virtual bool IsInside(const double* Coord, double tol=0);
+	virtual void IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol=0);
+	virtual bool GetSignedDistance(const double* Coord, double &dist);
 
 	virtual bool Update(string *ErrStr=NULL);
 	virtual bool Write2XML(TiXmlElement &elem, bool parameterised=true);
@@ -52,6 +57,10 @@ public:
 
 protected:
 	ParameterScalar psShellWidth;
+
+	//! Squared inner and outer radius of the shell, -1 if not limiting. Updated by Update().
+	double m_InnerRadiusSq;
+	double m_OuterRadiusSq;
 };
 
 
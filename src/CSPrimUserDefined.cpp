@@ -202,7 +202,7 @@ bool CSPrimUserDefined::Update(string *ErrStr)
 	}
 
 	//update local bounding box
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 
 	return bOK;
 }
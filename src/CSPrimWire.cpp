@@ -109,6 +109,18 @@ bool CSPrimWire::IsInside(const double* Coord, double /*tol*/)
 	return false;
 }
 
+bool CSPrimWire::GetSignedDistance(const double* Coord, double &dist)
+{
+	if ((Coord==NULL) || (GetNumberOfPoints()==0)) return false;
+	double pos[3];
+	//transform incoming coordinates into cartesian coords
+	TransformCoordSystem(Coord,pos,m_MeshType,CARTESIAN);
+	if (m_Transform)
+		m_Transform->InvertTransform(pos,pos);
+	dist = (GetCurveDistance(pos)-wireRadius.GetValue())*GetTransformDistanceScale();
+	return true;
+}
+
 bool CSPrimWire::Update(string *ErrStr)
 {
 	int EC=0;
@@ -126,7 +138,7 @@ bool CSPrimWire::Update(string *ErrStr)
 		PSErrorCode2Msg(EC,ErrStr);
 	}
 	//update local bounding box used to speedup IsInside()
-	GetBoundBox(m_BoundBox);
+	UpdateBoundBox();
 	return bOK;
 }
 
@@ -26,12 +26,15 @@
 #include "CSProperties.h"
 #include "CSFunctionParser.h"
 #include "CSUseful.h"
+#include "CSArena.h"
+#include "ContinuousStructure.h"
 
 #include <math.h>
 
 #define PI acos(-1)
 
 int g_PrimUniqueIDCounter=0;
+unsigned int CSPrimitives::s_UpdateRevision=0;
 
 void Point_Line_Distance(const double P[], const double start[], const double stop[], double &foot, double &dist, CoordinateSystem c_system)
 {
@@ -51,6 +54,13 @@ void Point_Line_Distance(const double P[], const double start[], const double st
 	dist = sqrt(pow(l_P[0]-footP[0],2)+pow(l_P[1]-footP[1],2)+pow(l_P[2]-footP[2],2));
 }
 
+double Orthogonal_Distance(double dist1, double dist2)
+{
+	if ((dist1>0) || (dist2>0))
+		return sqrt(pow(max(dist1,0.0),2)+pow(max(dist2,0.0),2));
+	return max(dist1,dist2);
+}
+
 bool CSXCAD_EXPORT CoordInRange(const double* coord, const double* start, const double* stop, CoordinateSystem cs_in)
 {
 	double p[] = {coord[0],coord[1],coord[2]};
@@ -78,8 +88,9 @@ bool CSXCAD_EXPORT CoordInRange(const double* coord, const double* start, const
 CSPrimitives::CSPrimitives(unsigned int ID, ParameterSet* paraSet, CSProperties* prop)
 {
 	clProperty=NULL;
-	SetProperty(prop);
 	uiID=ID;
+	// the ID is set first, the owning structure indexes the primitive by its ID
+	SetProperty(prop);
 	clParaSet=paraSet;
 	m_Transform=NULL;
 	iPriority=0;
@@ -91,16 +102,17 @@ CSPrimitives::CSPrimitives(unsigned int ID, ParameterSet* paraSet, CSProperties*
 	m_Dimension = 0;
 	for (int n=0;n<6;++n)
 		m_BoundBox[n]=0;
+	m_UpdateRevision = ++s_UpdateRevision;
 }
 
 CSPrimitives::CSPrimitives(CSPrimitives* prim, CSProperties *prop)
 {
 	clProperty=NULL;
+	uiID=g_PrimUniqueIDCounter++;
 	if (prop==NULL)
 		SetProperty(prim->clProperty);
 	else
 		SetProperty(prop);
-	uiID=g_PrimUniqueIDCounter++;
 	clParaSet=prim->clParaSet;
 	m_Transform=CSTransform::New(prim->m_Transform);
 	iPriority=prim->iPriority;
@@ -111,16 +123,17 @@ CSPrimitives::CSPrimitives(CSPrimitives* prim, CSProperties *prop)
 	m_Dimension = prim->m_Dimension;
 	for (int n=0;n<6;++n)
 		m_BoundBox[n]=0;
+	m_UpdateRevision = ++s_UpdateRevision;
 }
 
 
 CSPrimitives::CSPrimitives(ParameterSet* paraSet, CSProperties* prop)
 {
 	clProperty=NULL;
+	uiID=g_PrimUniqueIDCounter++;
 	SetProperty(prop);
 	clParaSet=paraSet;
 	m_Transform=NULL;
-	uiID=g_PrimUniqueIDCounter++;
 	iPriority=0;
 	PrimTypeName = string("Base Type");
 	m_Primtive_Used = false;
@@ -129,6 +142,15 @@ CSPrimitives::CSPrimitives(ParameterSet* paraSet, CSProperties* prop)
 	m_Dimension = 0;
 	for (int n=0;n<6;++n)
 		m_BoundBox[n]=0;
+	m_UpdateRevision = ++s_UpdateRevision;
+}
+
+void CSPrimitives::SetID(unsigned int ID)
+{
+	unsigned int oldID = uiID;
+	uiID=ID;
+	if (clProperty && clProperty->GetStructure())
+		clProperty->GetStructure()->IndexChangePrimitiveID(this,oldID);
 }
 
 void CSPrimitives::SetProperty(CSProperties *prop)
@@ -140,6 +162,16 @@ void CSPrimitives::SetProperty(CSProperties *prop)
 		prop->AddPrimitive(this);
 }
 
+void* CSPrimitives::operator new(size_t size)
+{
+	return CSArena::Allocate(size);
+}
+
+void CSPrimitives::operator delete(void* ptr)
+{
+	CSArena::Free(ptr);
+}
+
 CSPrimitives::~CSPrimitives()
 {
 	if (clProperty!=NULL)
@@ -196,3 +228,87 @@ void CSPrimitives::TransformCoords(double* Coord, bool invers, CoordinateSystem
 	// transform back from Cartesian to incoming coordinate system
 	TransformCoordSystem(Coord,Coord,CARTESIAN,cs_in);
 }
+
+double CSPrimitives::GetTransformDistanceScale() const
+{
+	if (m_Transform==NULL)
+		return 1.0;
+
+	// columns of the linear part of the inverse transformation
+	double origin[3] = {0,0,0};
+	double col[3][3];
+	m_Transform->InvertTransform(origin,origin);
+	double len[3];
+	for (int n=0;n<3;++n)
+	{
+		double unit[3] = {0,0,0};
+		unit[n] = 1;
+		m_Transform->InvertTransform(unit,col[n]);
+		for (int m=0;m<3;++m)
+			col[n][m] -= origin[m];
+		len[n] = sqrt(col[n][0]*col[n][0]+col[n][1]*col[n][1]+col[n][2]*col[n][2]);
+	}
+
+	// rotation and uniform scaling: orthogonal columns of equal length, distances scale exactly
+	bool conformal = (fabs(len[0]-len[1])<=1e-12*len[0]) && (fabs(len[0]-len[2])<=1e-12*len[0]);
+	for (int n=0;(n<3) && conformal;++n)
+	{
+		int m = (n+1)%3;
+		conformal = fabs(col[n][0]*col[m][0]+col[n][1]*col[m][1]+col[n][2]*col[m][2])<=1e-12*len[n]*len[m];
+	}
+	if (conformal)
+		return 1.0/len[0];
+	// the Frobenius norm is an upper bound of the largest singular value of the inverse
+	return 1.0/sqrt(len[0]*len[0]+len[1]*len[1]+len[2]*len[2]);
+}
+
+bool CSPrimitives::GetTransformedBoundBox(double dBoundBox[6])
+{
+	if (GetBoundBox(dBoundBox)==false)
+		return false;
+	if (GetBoundBoxCoordSystem()!=CARTESIAN)
+		return false;
+	// the bounding box is calculated from the coordinates only
+	if ((m_PrimCoordSystem!=UNDEFINED_CS) && (m_PrimCoordSystem!=CARTESIAN))
+		return false;
+	if (m_Transform==NULL)
+		return true;
+
+	// the bounding box of all transformed box corners is conservative for an affine transformation
+	double box[6];
+	double corner[3];
+	for (int n=0;n<6;++n)
+		box[n] = dBoundBox[n];
+	for (int c=0;c<8;++c)
+	{
+		for (int n=0;n<3;++n)
+			corner[n] = box[2*n+((c>>n)&1)];
+		m_Transform->Transform(corner,corner);
+		for (int n=0;n<3;++n)
+		{
+			if ((c==0) || (corner[n]<dBoundBox[2*n]))
+				dBoundBox[2*n] = corner[n];
+			if ((c==0) || (corner[n]>dBoundBox[2*n+1]))
+				dBoundBox[2*n+1] = corner[n];
+		}
+	}
+	return true;
+}
+
+void CSPrimitives::IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol)
+{
+	double coord[3];
+	for (size_t i=0;i<num;++i)
+	{
+		coord[0] = x[i];
+		coord[1] = y[i];
+		coord[2] = z[i];
+		inside[i] = IsInside(coord,tol);
+	}
+}
+
+void CSPrimitives::UpdateBoundBox()
+{
+	GetBoundBox(m_BoundBox);
+	m_UpdateRevision = ++s_UpdateRevision;
+}
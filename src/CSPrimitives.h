@@ -47,6 +47,8 @@ class CSPrimPolyhedron;
 class CSPrimCurve;
 	class CSPrimWire;
 class CSPrimUserDefined;
+class CSPrimInstance;
+class CSPrimCSG;
 
 class CSProperties; //include VisualProperties
 
@@ -63,6 +65,9 @@ void CSXCAD_EXPORT Point_Line_Distance(const double P[], const double start[], c
 
 bool CSXCAD_EXPORT CoordInRange(const double* p, const double* start, const double* stop, CoordinateSystem cs_in);
 
+//! Signed distance to the intersection of two regions, given by the signed distances in orthogonal directions (e.g. the radial and axial distance to a cylinder).
+double CSXCAD_EXPORT Orthogonal_Distance(double dist1, double dist2);
+
 //! Abstract base class for different geometrical primitives.
 /*!
  This is an abstract base class for different geometrical primitives like boxes, spheres, cylinders etc.
@@ -73,11 +78,15 @@ class CSXCAD_EXPORT CSPrimitives
 public:
 	virtual ~CSPrimitives();
 
+	//! Primitives are allocated from the current arena, e.g. of the structure reading them. \sa CSArena
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+
 	//! Primitive type definitions.
 	enum PrimitiveType
 	{
 		POINT,BOX,MULTIBOX,SPHERE,SPHERICALSHELL,CYLINDER,CYLINDRICALSHELL,POLYGON,LINPOLY,ROTPOLY,POLYHEDRON,CURVE,WIRE,USERDEFINED,
-		POLYHEDRONREADER
+		POLYHEDRONREADER,INSTANCE,CSG
 	};
 
 	//! Set or change the property for this primitive.
@@ -88,7 +97,7 @@ public:
 	//! Getthe unique ID for this primitive.
 	unsigned int GetID() {return uiID;}
 	//! Change the unique ID for this primitive. This is not recommended! Be sure what you are doing!
-	void SetID(unsigned int ID) {uiID=ID;}
+	void SetID(unsigned int ID);
 
 	//! Get the type of this primitive. \sa PrimitiveType
 	int GetType() {return Type;}
@@ -102,12 +111,26 @@ public:
 	virtual bool GetBoundBox(double dBoundBox[6], bool PreserveOrientation=false) {UNUSED(PreserveOrientation);UNUSED(dBoundBox);return false;}
 
 	virtual CoordinateSystem GetBoundBoxCoordSystem() const {return m_BoundBox_CoordSys;}
+	//! Get a conservative cartesian bounding box, including the transformation of this primitive. \return false if no such bounding box is available.
+	bool GetTransformedBoundBox(double dBoundBox[6]);
 
 	//! Get the dimension of this primitive
 	virtual int GetDimension() {return m_Dimension;}
 
 	//! Check if given Coordinate (in the given mesh type) is inside the Primitive.
 	virtual bool IsInside(const double* Coord, double tol=0) {UNUSED(Coord);UNUSED(tol);return false;}
+	//! Check a number of coordinates at once, given as separate x, y and z arrays. \sa IsInside
+	virtual void IsInsideBatch(size_t num, const double* x, const double* y, const double* z, bool* inside, double tol=0);
+
+	//! Get the signed distance of the given coordinate (in the given mesh type) to the surface of this primitive.
+	/*!
+	 The distance is negative inside and positive outside of the primitive.
+	 In case of a transformation other than a rotation, translation or uniform scaling, the absolute value is a lower bound of the true distance.
+	 \return false if the distance can not be calculated for this primitive.
+	 */
+	virtual bool GetSignedDistance(const double* Coord, double &dist) {UNUSED(Coord);UNUSED(dist);return false;}
+	//! Get the factor to convert a distance in the untransformed primitive into the mesh, a lower bound for non-uniform scaling. \sa GetSignedDistance
+	double GetTransformDistanceScale() const;
 
 	//! Check whether this primitive was used. (--> IsInside() return true) \sa SetPrimitiveUsed
 	bool GetPrimitiveUsed() {return m_Primtive_Used;}
@@ -115,7 +138,7 @@ public:
 	void SetPrimitiveUsed(bool val) {m_Primtive_Used=val;}
 
 	//! Set or change the priotity for this primitive.
-	void SetPriority(int val) {iPriority=val;}
+	void SetPriority(int val) {iPriority=val;++s_UpdateRevision;}
 	//! Get the priotity for this primitive.
 	int GetPriority() {return iPriority;}
 
@@ -156,6 +179,10 @@ public:
 	CSPrimUserDefined* ToUserDefined() { return ( this && Type == USERDEFINED ) ? (CSPrimUserDefined*) this : 0; } /// Cast Primitive to a more defined type. Will return null if not of the requested type.
 	//! Get the corresponing Point-Primitive or 0 in case of different type.
 	CSPrimPoint* ToPoint() { return ( this && Type == POINT ) ? (CSPrimPoint*) this : 0; } //!< Cast Primitive to a more defined type. Will return 0 if not of the requested type.
+	//! Get the corresponing Instance-Primitive or NULL in case of different type.
+	CSPrimInstance* ToInstance() { return ( this && Type == INSTANCE ) ? (CSPrimInstance*) this : 0; } /// Cast Primitive to a more defined type. Will return null if not of the requested type.
+	//! Get the corresponing CSG-Primitive or NULL in case of different type.
+	CSPrimCSG* ToCSG() { return ( this && Type == CSG ) ? (CSPrimCSG*) this : 0; } /// Cast Primitive to a more defined type. Will return null if not of the requested type.
 
 	bool operator<(CSPrimitives& vgl) { return iPriority<vgl.GetPriority();}
 	bool operator>(CSPrimitives& vgl) { return iPriority>vgl.GetPriority();}
@@ -174,6 +201,11 @@ public:
 
 	CSTransform* GetTransform() const {return m_Transform;}
 
+	//! Get the revision of this primitive, changes with every Update(). Can be used to detect modified primitives.
+	unsigned int GetUpdateRevision() const {return m_UpdateRevision;}
+	//! Get the global revision of all primitives, changes with every Update() or priority change of any primitive. \sa GetUpdateRevision
+	static unsigned int GetGlobalUpdateRevision() {return s_UpdateRevision;}
+
 	//! Show status of this primitve
 	virtual void ShowPrimitiveStatus(ostream& stream);
 
@@ -184,6 +216,8 @@ protected:
 
 	//! Apply (invers) transformation to the given coordinate in the given coordinate system
 	void TransformCoords(double* Coord, bool invers, CoordinateSystem cs_in) const;
+	//! Update the internal bounding box and the update revision, to be called by Update(). \sa GetUpdateRevision
+	void UpdateBoundBox();
 
 	unsigned int uiID;
 	int iPriority;
@@ -200,6 +234,9 @@ protected:
 	double m_BoundBox[6];
 	CoordinateSystem m_BoundBox_CoordSys;
 
+	unsigned int m_UpdateRevision;
+	static unsigned int s_UpdateRevision;
+
 	int m_Dimension;
 };
 
@@ -18,12 +18,20 @@
 #include "tinyxml.h"
 #include <hdf5.h>
 #include <hdf5_hl.h>
+#include <boost/thread.hpp>
+
+#if !defined(WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "vtkPolyData.h"
 #include "vtkCellArray.h"
 #include "vtkPoints.h"
 
 #include "ParameterCoord.h"
+#include "CSRectGrid.h"
 #include "CSPropDiscMaterial.h"
 
 #define vtkRenderingCore_AUTOINIT4(vtkInteractionStyle,vtkRenderingFreeType,vtkRenderingFreeTypeOpenGL,vtkRenderingOpenGL)
@@ -54,8 +62,7 @@ CSPropDiscMaterial::~CSPropDiscMaterial()
 		delete[] m_mesh[n];
 		m_mesh[n]=NULL;
 	}
-	delete[] m_Disc_Ind;
-	m_Disc_Ind=NULL;
+	ReleaseIndexData();
 	delete[] m_Disc_epsR;
 	m_Disc_epsR=NULL;
 	delete[] m_Disc_kappa;
@@ -84,21 +91,53 @@ unsigned int CSPropDiscMaterial::GetWeightingPos(const double* inCoords)
 		return -1;
 	for (int n=0;n<3;++n)
 	{
-		if (coords[n]<m_mesh[n][0])
+		const float* mesh = m_mesh[n];
+		if (coords[n]<mesh[0])
 			return -1;
-		if (coords[n]>m_mesh[n][m_Size[n]-1])
+		if (coords[n]>mesh[m_Size[n]-1])
 			return -1;
-		pos[n]=0;
-		for (unsigned int i=1;i<m_Size[n];++i)
+		if (m_UniformMesh[n])
+		{
+			// direct lookup, corrected by one cell in case of rounding errors
+			pos[n] = (unsigned int)((coords[n]-mesh[0])*m_InvMeshDelta[n]);
+			if (pos[n]>m_Size[n]-2)
+				pos[n]=m_Size[n]-2;
+			if ((pos[n]>0) && (coords[n]<mesh[pos[n]]))
+				--pos[n];
+			else if ((pos[n]<m_Size[n]-2) && (coords[n]>=mesh[pos[n]+1]))
+				++pos[n];
+		}
+		else
 		{
-			if (coords[n]<m_mesh[n][i])
+			// first line above the coordinate, the last line belongs to the last cell
+			pos[n] = upper_bound(mesh, mesh+m_Size[n], coords[n]) - mesh;
+			pos[n] = min(max(pos[n],1u)-1,m_Size[n]-2);
+		}
+	}
+	return pos[0] + pos[1]*(m_Size[0]-1) + pos[2]*(m_Size[0]-1)*(m_Size[1]-1);
+}
+
+void CSPropDiscMaterial::AnalyseMesh()
+{
+	for (int n=0;n<3;++n)
+	{
+		m_UniformMesh[n] = false;
+		m_InvMeshDelta[n] = 0;
+		if ((m_mesh[n]==NULL) || (m_Size[n]<2))
+			continue;
+		double delta = ((double)m_mesh[n][m_Size[n]-1]-m_mesh[n][0])/(m_Size[n]-1);
+		if (delta<=0)
+			continue;
+		m_UniformMesh[n] = true;
+		for (unsigned int i=1;i<m_Size[n];++i)
+			if (fabs(m_mesh[n][i]-m_mesh[n][i-1]-delta)>1e-4*delta)
 			{
-				pos[n]=i-1;
+				m_UniformMesh[n] = false;
 				break;
 			}
-		}
+		if (m_UniformMesh[n])
+			m_InvMeshDelta[n] = 1.0/delta;
 	}
-	return pos[0] + pos[1]*(m_Size[0]-1) + pos[2]*(m_Size[0]-1)*(m_Size[1]-1);
 }
 
 int CSPropDiscMaterial::GetDBPos(const double* coords)
@@ -171,6 +210,21 @@ double CSPropDiscMaterial::GetDensityWeighted(const double* inCoords)
 	return m_Disc_Density[pos];
 }
 
+void CSPropDiscMaterial::GetAllWeighted(const double* inCoords, double values[5], int ny)
+{
+	// the position is looked up only once, the base class methods are called directly to avoid the lookup in the overloaded methods
+	int pos = GetDBPos(inCoords);
+	float* db[5] = {m_Disc_epsR, m_Disc_kappa, m_Disc_mueR, m_Disc_sigma, m_Disc_Density};
+	if (pos<0)
+		for (int n=0;n<5;++n)
+			db[n] = NULL;
+	values[0] = db[0] ? db[0][pos] : CSPropMaterial::GetEpsilonWeighted(ny,inCoords);
+	values[1] = db[1] ? db[1][pos] : CSPropMaterial::GetKappaWeighted(ny,inCoords);
+	values[2] = db[2] ? db[2][pos] : CSPropMaterial::GetMueWeighted(ny,inCoords);
+	values[3] = db[3] ? db[3][pos] : CSPropMaterial::GetSigmaWeighted(ny,inCoords);
+	values[4] = db[4] ? db[4][pos] : CSPropMaterial::GetDensityWeighted(inCoords);
+}
+
 void CSPropDiscMaterial::Init()
 {
 	m_Filename.clear();
@@ -180,7 +234,11 @@ void CSPropDiscMaterial::Init()
 	m_DB_Background = true;
 
 	for (int n=0;n<3;++n)
+	{
 		m_mesh[n]=NULL;
+		m_UniformMesh[n]=false;
+		m_InvMeshDelta[n]=0;
+	}
 	m_Disc_Ind=NULL;
 	m_Disc_epsR=NULL;
 	m_Disc_kappa=NULL;
@@ -191,6 +249,17 @@ void CSPropDiscMaterial::Init()
 	m_Scale=1;
 	m_Transform=NULL;
 
+	m_Resampled_CS=CARTESIAN;
+
+	m_UseMemoryMap=false;
+	m_MappedData=NULL;
+	m_MappedSize=0;
+
+	m_UseSimArea=false;
+	m_SimArea_CS=CARTESIAN;
+	for (int n=0;n<6;++n)
+		m_SimArea[n]=0;
+
 	CSPropMaterial::Init();
 }
 
@@ -205,6 +274,8 @@ bool CSPropDiscMaterial::Write2XML(TiXmlNode& root, bool parameterised, bool spa
 	filename.SetAttribute("File",m_Filename.c_str());
 	filename.SetAttribute("UseDBBackground",m_DB_Background);
 	filename.SetAttribute("Scale",m_Scale);
+	if (m_UseMemoryMap)
+		filename.SetAttribute("UseMemoryMap",1);
 
 	if (m_Transform)
 		m_Transform->Write2XML(prop);
@@ -235,6 +306,9 @@ bool CSPropDiscMaterial::ReadFromXML(TiXmlNode &root)
 	if (prop->QueryDoubleAttribute("Scale",&m_Scale)!=TIXML_SUCCESS)
 		m_Scale=1;
 
+	if (prop->QueryIntAttribute("UseMemoryMap",&help)==TIXML_SUCCESS)
+		SetUseMemoryMap(help!=0);
+
 	if (c_filename==NULL)
 		return true;
 
@@ -246,92 +320,142 @@ bool CSPropDiscMaterial::ReadFromXML(TiXmlNode &root)
 	return true;
 }
 
-void *CSPropDiscMaterial::ReadDataSet(string filename, string d_name, int type_id, int &rank, unsigned int &size, bool debug)
+//! Read a one-dimensional float dataset from an open hdf5 file. \return NULL on error
+static float* ReadMeshDataSet(hid_t file_id, const char* d_name, unsigned int &size)
 {
-	herr_t status;
+	if (H5Lexists(file_id, d_name, H5P_DEFAULT)<=0)
+		return NULL;
+	int rank;
+	if ((H5LTget_dataset_ndims(file_id, d_name, &rank)<0) || (rank!=1))
+		return NULL;
+	hsize_t dims[1];
 	H5T_class_t class_id;
 	size_t type_size;
-	rank = -1;
-
-	// open hdf5 file
-	hid_t file_id = H5Fopen( filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT );
-	if (file_id < 0)
+	if (H5LTget_dataset_info(file_id, d_name, dims, &class_id, &type_size)<0)
+		return NULL;
+	size = dims[0];
+	float* data = new float[size];
+	if (H5LTread_dataset_float(file_id, d_name, data)<0)
 	{
-		if (debug)
-			cerr << __func__ << ": Failed to open file, skipping..." << endl;
-		H5Fclose(file_id);
+		delete[] data;
 		return NULL;
 	}
+	return data;
+}
 
-	if (H5Lexists(file_id, d_name.c_str(), H5P_DEFAULT)<=0)
+void CSPropDiscMaterial::SetSimulationArea(const double area[6], CoordinateSystem cs)
+{
+	m_UseSimArea = true;
+	m_SimArea_CS = cs;
+	for (int n=0;n<6;++n)
+		m_SimArea[n] = area[n];
+}
+
+bool CSPropDiscMaterial::GetSimAreaCellRange(unsigned int start[3], unsigned int stop[3])
+{
+	for (int n=0;n<3;++n)
 	{
-		if (debug)
-			cerr << __func__ << ": Warning, dataset: \"" << d_name << "\" not found... skipping" << endl;
-		H5Fclose(file_id);
-		return NULL;
+		start[n] = 0;
+		stop[n] = m_Size[n]-2;
 	}
+	if (m_UseSimArea==false)
+		return true;
 
-	status = H5LTget_dataset_ndims(file_id, d_name.c_str(), &rank);
-	if (status < 0)
+	// cartesian bounding box of the simulation area
+	double box[6];
+	for (int n=0;n<6;++n)
+		box[n] = m_SimArea[n];
+	if (m_SimArea_CS==CYLINDRICAL)
 	{
-		if (debug)
-			cerr << __func__ << ": Warning, failed to read dimension for dataset: \"" << d_name << "\" skipping..." << endl;
-		H5Fclose(file_id);
-		return NULL;
+		double r_max = max(fabs(m_SimArea[0]),fabs(m_SimArea[1]));
+		box[0] = box[2] = -r_max;
+		box[1] = box[3] = r_max;
 	}
 
-	hsize_t dims[rank];
-	status = H5LTget_dataset_info( file_id, d_name.c_str(), dims, &class_id, &type_size);
-	if (status < 0)
+	// bounding box of all (transformed) corners in the material coordinates
+	double range[6] = {0,0,0,0,0,0};
+	for (int c=0;c<8;++c)
 	{
-		if (debug)
-			cerr << __func__ << ": Warning, failed to read dataset info: \"" << d_name << "\" skipping..." << endl;
-		H5Fclose(file_id);
-		return NULL;
+		double corner[3] = {box[c&1], box[2+((c>>1)&1)], box[4+((c>>2)&1)]};
+		if (m_Transform)
+			m_Transform->InvertTransform(corner,corner);
+		for (int n=0;n<3;++n)
+		{
+			corner[n]/=m_Scale;
+			if ((c==0) || (corner[n]<range[2*n]))
+				range[2*n] = corner[n];
+			if ((c==0) || (corner[n]>range[2*n+1]))
+				range[2*n+1] = corner[n];
+		}
 	}
 
-	size = 1;
-	for (int n=0;n<rank;++n)
-		size*=dims[n];
+	for (int n=0;n<3;++n)
+	{
+		const float* mesh = m_mesh[n];
+		if ((range[2*n+1]<mesh[0]) || (range[2*n]>mesh[m_Size[n]-1]))
+			return false;
+		// same cell search as GetWeightingPos, extended by one cell to be safe against rounding errors
+		unsigned int pos = upper_bound(mesh, mesh+m_Size[n], range[2*n]) - mesh;
+		start[n] = min(max(pos,2u)-2,m_Size[n]-2);
+		pos = upper_bound(mesh, mesh+m_Size[n], range[2*n+1]) - mesh;
+		stop[n] = min(pos,m_Size[n]-2);
+	}
+	return true;
+}
 
-	void* data;
-	if (type_id==H5T_NATIVE_FLOAT)
-		data = (void*) new float[size];
-	else if (type_id==H5T_NATIVE_INT)
-		data = (void*) new int[size];
-	else if (type_id==H5T_NATIVE_UINT8)
-		data = (void*) new uint8[size];
-	else
+//! Map a contiguous dataset of an open hdf5 file read-only into memory. \return Start of the mapping or NULL on error
+static void* MapDataSet(const string &filename, hid_t file_id, hid_t dataset, size_t size, size_t &map_size, size_t &data_offset)
+{
+#if defined(WIN32)
+	UNUSED(filename);UNUSED(file_id);UNUSED(dataset);UNUSED(size);UNUSED(map_size);UNUSED(data_offset);
+	cerr << __func__ << ": Warning, memory mapping is not supported on this platform, reading the data instead." << endl;
+	return NULL;
+#else
+	// only a contiguous, unfiltered dataset of bytes can be mapped directly
+	hid_t dcpl = H5Dget_create_plist(dataset);
+	bool contiguous = (H5Pget_layout(dcpl)==H5D_CONTIGUOUS) && (H5Pget_nfilters(dcpl)==0);
+	H5Pclose(dcpl);
+	hid_t type = H5Dget_type(dataset);
+	bool is_uint8 = H5Tequal(type, H5T_NATIVE_UINT8)>0;
+	H5Tclose(type);
+	haddr_t offset = H5Dget_offset(dataset);
+	if (!contiguous || !is_uint8 || (offset==HADDR_UNDEF))
 	{
-		cerr << __func__ << ": Error, unknown data type" << endl;
-		H5Fclose(file_id);
+		cerr << __func__ << ": Warning, the material index volume is chunked, compressed or not allocated and can't be mapped, reading the data instead." << endl;
 		return NULL;
 	}
 
-	status = H5LTread_dataset( file_id, d_name.c_str(), type_id, data );
-	if (status < 0)
+	// the dataset offset is relative to the end of a possible user block
+	hid_t fcpl = H5Fget_create_plist(file_id);
+	hsize_t userblock = 0;
+	H5Pget_userblock(fcpl, &userblock);
+	H5Pclose(fcpl);
+	offset += userblock;
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd<0)
+		return NULL;
+	off_t page_size = sysconf(_SC_PAGESIZE);
+	off_t map_start = (offset/page_size)*page_size;
+	map_size = size + (offset-map_start);
+	void* addr = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, map_start);
+	close(fd);
+	if (addr==MAP_FAILED)
 	{
-		if (debug)
-			cerr << __func__ << ": Warning, failed to read dataset: \"" << d_name << "\" skipping..." << endl;
-		if (type_id==H5T_NATIVE_FLOAT)
-			delete[] (float*)data;
-		else if (type_id==H5T_NATIVE_INT)
-			delete[] (int*)data;
-		else if (type_id==H5T_NATIVE_UINT8)
-			delete[] (uint8*)data;
-		H5Fclose(file_id);
+		cerr << __func__ << ": Warning, failed to map the material index volume, reading the data instead." << endl;
 		return NULL;
 	}
-
-	H5Fclose(file_id);
-	return data;
+	data_offset = offset-map_start;
+	return addr;
+#endif
 }
 
 bool CSPropDiscMaterial::ReadHDF5( string filename )
 {
 	cout << __func__ << ": Reading \"" << filename << "\"" << endl;
+	ClearResampledData();
 
-	// open hdf5 file
+	// open hdf5 file once for all datasets
 	hid_t file_id = H5Fopen( filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT );
 	if (file_id < 0)
 	{
@@ -373,102 +497,305 @@ bool CSPropDiscMaterial::ReadHDF5( string filename )
 	{
 		cerr << __func__ << ": Error, can't open database" << endl;
 		H5Fclose(file_id);
-		return 0;
+		return false;
 	}
 
 	// read database
-	if (H5LTfind_attribute(dataset, "epsR")==1)
+	const char* db_names[5] = {"epsR", "kappa", "mueR", "sigma", "density"};
+	float** db_values[5] = {&m_Disc_epsR, &m_Disc_kappa, &m_Disc_mueR, &m_Disc_sigma, &m_Disc_Density};
+	for (int n=0;n<5;++n)
 	{
-		m_Disc_epsR = new float[db_size];
-		status = H5LTget_attribute_float(file_id, "/DiscData", "epsR", m_Disc_epsR);
+		delete[] *db_values[n];
+		*db_values[n] = NULL;
+		if (H5LTfind_attribute(dataset, db_names[n])==1)
+		{
+			*db_values[n] = new float[db_size];
+			status = H5LTget_attribute_float(file_id, "/DiscData", db_names[n], *db_values[n]);
+		}
+		else
+			cerr << __func__ << ": No \"/DiscData/" << db_names[n] << "\" found, skipping..." << endl;
 	}
-	else
+
+	// read mesh
+	const char* names[] = {"/mesh/x","/mesh/y","/mesh/z"};
+	for (int n=0; n<3; ++n)
 	{
-		cerr << __func__ << ": No \"/DiscData/epsR\" found, skipping..." << endl;
-		m_Disc_epsR=NULL;
+		delete[] m_mesh[n];
+		unsigned int size=0;
+		m_mesh[n] = ReadMeshDataSet(file_id, names[n], size);
+		if ((m_mesh[n]==NULL) || (size<=1))
+		{
+			cerr << __func__ << ": Error, failed to read or invalid mesh, abort..." << endl;
+			H5Dclose(dataset);
+			H5Fclose(file_id);
+			return false;
+		}
+		m_Size[n]=size;
 	}
 
-	delete[] m_Disc_kappa;
-	if (H5LTfind_attribute(dataset, "kappa")==1)
+	ReleaseIndexData();
+
+	// check the index volume, stored with the x-index running fastest
+	hid_t space = H5Dget_space(dataset);
+	int rank = H5Sget_simple_extent_ndims(space);
+	hsize_t dims[3] = {0,0,0};
+	if (rank==3)
+		H5Sget_simple_extent_dims(space, dims, NULL);
+	bool ordered = (dims[0]==m_Size[2]-1) && (dims[1]==m_Size[1]-1) && (dims[2]==m_Size[0]-1);
+	if ((rank!=3) || (dims[0]*dims[1]*dims[2]!=(hsize_t)(m_Size[0]-1)*(m_Size[1]-1)*(m_Size[2]-1)))
 	{
-		m_Disc_kappa = new float[db_size];
-		status = H5LTget_attribute_float(file_id, "/DiscData", "kappa", m_Disc_kappa);
+		cerr << __func__ << ": Error, can't read database indizies or size/rank is invalid, abort..." << endl;
+		H5Sclose(space);
+		H5Dclose(dataset);
+		H5Fclose(file_id);
+		return false;
 	}
-	else
+
+	// only read the part overlapping the simulation area, chunked and compressed datasets are handled by hdf5
+	size_t data_offset = 0;
+	if (m_UseMemoryMap)
+		m_MappedData = MapDataSet(filename, file_id, dataset, dims[0]*dims[1]*dims[2], m_MappedSize, data_offset);
+	if (m_MappedData)
 	{
-		cerr << __func__ << ": No \"/DiscData/kappa\" found, skipping..." << endl;
-		m_Disc_kappa=NULL;
+		m_Disc_Ind = (uint8*)m_MappedData + data_offset;
+		H5Sclose(space);
+		H5Dclose(dataset);
+		H5Fclose(file_id);
+		AnalyseMesh();
+		return true;
 	}
 
-	delete[] m_Disc_mueR;
-	if (H5LTfind_attribute(dataset, "mueR")==1)
+	unsigned int start[3], stop[3];
+	if (ordered==false)
 	{
-		m_Disc_mueR = new float[db_size];
-		status = H5LTget_attribute_float(file_id, "/DiscData", "mueR", m_Disc_mueR);
+		// unexpected dimension order, read the full volume
+		for (int n=0;n<3;++n)
+		{
+			start[n] = 0;
+			stop[n] = m_Size[n]-2;
+		}
 	}
-	else
+	else if (GetSimAreaCellRange(start,stop)==false)
 	{
-		cerr << __func__ << ": No \"/DiscData/mueR\" found, skipping..." << endl;
-		m_Disc_mueR=NULL;
+		cerr << __func__ << ": Warning, material volume is outside of the simulation area, skipping..." << endl;
+		H5Sclose(space);
+		H5Dclose(dataset);
+		H5Fclose(file_id);
+		for (int n=0;n<3;++n)
+		{
+			delete[] m_mesh[n];
+			m_mesh[n]=NULL;
+		}
+		return true;
 	}
-
-	delete[] m_Disc_sigma;
-	if (H5LTfind_attribute(dataset, "sigma")==1)
+	hsize_t offset[3] = {start[2], start[1], start[0]};
+	hsize_t count[3] = {stop[2]-start[2]+1, stop[1]-start[1]+1, stop[0]-start[0]+1};
+	m_Disc_Ind = new uint8[count[0]*count[1]*count[2]];
+	if (ordered)
 	{
-		m_Disc_sigma = new float[db_size];
-		status = H5LTget_attribute_float(file_id, "/DiscData", "sigma", m_Disc_sigma);
+		H5Sselect_hyperslab(space, H5S_SELECT_SET, offset, NULL, count, NULL);
+		hid_t memspace = H5Screate_simple(3, count, NULL);
+		status = H5Dread(dataset, H5T_NATIVE_UINT8, memspace, space, H5P_DEFAULT, m_Disc_Ind);
+		H5Sclose(memspace);
 	}
 	else
+		status = H5Dread(dataset, H5T_NATIVE_UINT8, H5S_ALL, H5S_ALL, H5P_DEFAULT, m_Disc_Ind);
+	H5Sclose(space);
+	H5Dclose(dataset);
+	H5Fclose(file_id);
+	if (status<0)
 	{
-		cerr << __func__ << ": No \"/DiscData/sigma\" found, skipping..." << endl;
-		m_Disc_sigma=NULL;
+		cerr << __func__ << ": Error, can't read database indizies, abort..." << endl;
+		ReleaseIndexData();
+		return false;
 	}
 
-	delete[] m_Disc_Density;
-	if (H5LTfind_attribute(dataset, "density")==1)
+	// crop the mesh to the read cells
+	for (int n=0;n<3;++n)
 	{
-		m_Disc_Density = new float[db_size];
-		status = H5LTget_attribute_float(file_id, "/DiscData", "density", m_Disc_Density);
+		if ((start[n]==0) && (stop[n]==m_Size[n]-2))
+			continue;
+		unsigned int size = stop[n]-start[n]+2;
+		float* mesh = new float[size];
+		for (unsigned int i=0;i<size;++i)
+			mesh[i] = m_mesh[n][start[n]+i];
+		delete[] m_mesh[n];
+		m_mesh[n] = mesh;
+		m_Size[n] = size;
 	}
-	else
+	AnalyseMesh();
+	return true;
+}
+
+void CSPropDiscMaterial::ReleaseIndexData()
+{
+#if !defined(WIN32)
+	if (m_MappedData)
 	{
-		cerr << __func__ << ": no \"/DiscData/density\" found, skipping..." << endl;
-		m_Disc_Density=NULL;
+		munmap(m_MappedData, m_MappedSize);
+		m_MappedData = NULL;
+		m_MappedSize = 0;
+		m_Disc_Ind = NULL;
 	}
+#endif
+	delete[] m_Disc_Ind;
+	m_Disc_Ind = NULL;
+}
 
-	H5Fclose(file_id);
+//! Worker resampling every n-th z-plane of a discrete material. \sa CSPropDiscMaterial::ResampleToGrid
+struct CSResampleWorker
+{
+	CSPropDiscMaterial* material;
+	unsigned int start;
+	unsigned int step;
+	unsigned int subSamples;
+	void operator()()
+	{
+		material->ResamplePlanes(start,step,subSamples);
+	}
+};
 
-	// read mesh
-	unsigned int size;
-	int rank;
-	unsigned int numCells = 1;
-	string names[] = {"/mesh/x","/mesh/y","/mesh/z"};
-	for (int n=0; n<3; ++n)
+bool CSPropDiscMaterial::ResampleToGrid(CSRectGrid* grid, unsigned int subSamples, unsigned int numThreads)
+{
+	ClearResampledData();
+	if ((grid==NULL) || (grid->isValid()==false) || (m_Disc_Ind==NULL) || (subSamples<1))
+		return false;
+
+	unsigned int numCells[3];
+	for (int n=0;n<3;++n)
 	{
-		m_mesh[n] = (float*)ReadDataSet(filename, names[n], H5T_NATIVE_FLOAT, rank, size);
-		if ((m_mesh[n]==NULL) || (rank!=1) || (size<=1))
-		{
-			cerr << __func__ << ": Error, failed to read or invalid mesh, abort..." << endl;
-			H5Fclose(file_id);
-			return false;
-		}
-		m_Size[n]=size;
-		numCells*=(m_Size[n]-1);
+		m_Resampled_Lines[n].resize(grid->GetQtyLines(n));
+		for (size_t i=0;i<m_Resampled_Lines[n].size();++i)
+			m_Resampled_Lines[n].at(i) = grid->GetLine(n,i);
+		numCells[n] = m_Resampled_Lines[n].size()-1;
 	}
+	m_Resampled_DBPos.resize((size_t)numCells[0]*numCells[1]*numCells[2]);
+	m_Resampled_CS = grid->GetMeshType();
 
-	delete[] m_Disc_Ind;
-	m_Disc_Ind = (uint8*)ReadDataSet(filename, "/DiscData", H5T_NATIVE_UINT8, rank, size, true);
+	if (numThreads>numCells[2])
+		numThreads = numCells[2];
+	if (numThreads<1)
+		numThreads = 1;
 
-	if ((m_Disc_Ind==NULL) || (rank!=3) || (size!=numCells))
+	// each z-plane is independent and written to a disjoint slice of the resampled data
+	boost::thread_group threads;
+	for (unsigned int t=0;t<numThreads;++t)
 	{
-		cerr << __func__ << ": Error, can't read database indizies or size/rank is invalid, abort..." << endl;
-		delete[] m_Disc_Ind;
-		m_Disc_Ind = NULL;
-		return false;
+		CSResampleWorker worker;
+		worker.material = this;
+		worker.start = t;
+		worker.step = numThreads;
+		worker.subSamples = subSamples;
+		if (t==numThreads-1)
+			worker(); // use the calling thread for the last share
+		else
+			threads.create_thread(worker);
 	}
+	threads.join_all();
 	return true;
 }
 
+void CSPropDiscMaterial::ResamplePlanes(unsigned int start, unsigned int step, unsigned int subSamples)
+{
+	unsigned int numCells[3];
+	for (int n=0;n<3;++n)
+		numCells[n] = m_Resampled_Lines[n].size()-1;
+
+	// votes for each database position, slot 0 is used for the background (db position -1)
+	vector<unsigned int> votes(m_DB_size+1);
+	unsigned int cell[3], sub[3];
+	double coord[3];
+	for (cell[2]=start;cell[2]<numCells[2];cell[2]+=step)
+	{
+		// the cell index is x-fastest as the original material volume
+		size_t idx = (size_t)numCells[0]*numCells[1]*cell[2];
+		for (cell[1]=0;cell[1]<numCells[1];++cell[1])
+			for (cell[0]=0;cell[0]<numCells[0];++cell[0])
+			{
+				int db_pos = -1;
+				if (subSamples==1)
+				{
+					for (int n=0;n<3;++n)
+						coord[n] = 0.5*(m_Resampled_Lines[n].at(cell[n])+m_Resampled_Lines[n].at(cell[n]+1));
+					TransformCoordSystem(coord, coord, m_Resampled_CS, coordInputType);
+					db_pos = GetDBPos(coord);
+				}
+				else
+				{
+					fill(votes.begin(),votes.end(),0);
+					for (sub[2]=0;sub[2]<subSamples;++sub[2])
+						for (sub[1]=0;sub[1]<subSamples;++sub[1])
+							for (sub[0]=0;sub[0]<subSamples;++sub[0])
+							{
+								for (int n=0;n<3;++n)
+								{
+									double lo = m_Resampled_Lines[n].at(cell[n]);
+									double hi = m_Resampled_Lines[n].at(cell[n]+1);
+									coord[n] = lo + (hi-lo)*(0.5+sub[n])/subSamples;
+								}
+								TransformCoordSystem(coord, coord, m_Resampled_CS, coordInputType);
+								++votes.at(GetDBPos(coord)+1);
+							}
+					db_pos = (int)(max_element(votes.begin(),votes.end())-votes.begin()) - 1;
+				}
+				m_Resampled_DBPos[idx++] = (short)db_pos;
+			}
+	}
+}
+
+void CSPropDiscMaterial::ClearResampledData()
+{
+	m_Resampled_DBPos.clear();
+	for (int n=0;n<3;++n)
+		m_Resampled_Lines[n].clear();
+}
+
+int CSPropDiscMaterial::GetResampledDBPos(const unsigned int cell[3]) const
+{
+	if (m_Resampled_DBPos.size()==0)
+		return -1;
+	for (int n=0;n<3;++n)
+		if (cell[n]+1>=m_Resampled_Lines[n].size())
+			return -1;
+	size_t Nx = m_Resampled_Lines[0].size()-1;
+	size_t Ny = m_Resampled_Lines[1].size()-1;
+	return m_Resampled_DBPos[cell[0] + Nx*(cell[1] + Ny*cell[2])];
+}
+
+void CSPropDiscMaterial::GetResampledWeighted(const unsigned int cell[3], double values[5], int ny)
+{
+	int pos = GetResampledDBPos(cell);
+	float* db[5] = {m_Disc_epsR, m_Disc_kappa, m_Disc_mueR, m_Disc_sigma, m_Disc_Density};
+	bool fallback = (pos<0);
+	for (int n=0;n<5;++n)
+	{
+		if ((pos>=0) && db[n])
+			values[n] = db[n][pos];
+		else
+			fallback = true;
+	}
+	if (fallback==false)
+		return;
+
+	// background material (or missing database values), evaluate at the cell center
+	double coord[3] = {0,0,0};
+	if (m_Resampled_DBPos.size()>0)
+		for (int n=0;n<3;++n)
+			if (cell[n]+1<m_Resampled_Lines[n].size())
+				coord[n] = 0.5*(m_Resampled_Lines[n].at(cell[n])+m_Resampled_Lines[n].at(cell[n]+1));
+	TransformCoordSystem(coord, coord, m_Resampled_CS, coordInputType);
+	if ((pos<0) || (db[0]==NULL))
+		values[0] = CSPropMaterial::GetEpsilonWeighted(ny,coord);
+	if ((pos<0) || (db[1]==NULL))
+		values[1] = CSPropMaterial::GetKappaWeighted(ny,coord);
+	if ((pos<0) || (db[2]==NULL))
+		values[2] = CSPropMaterial::GetMueWeighted(ny,coord);
+	if ((pos<0) || (db[3]==NULL))
+		values[3] = CSPropMaterial::GetSigmaWeighted(ny,coord);
+	if ((pos<0) || (db[4]==NULL))
+		values[4] = CSPropMaterial::GetDensityWeighted(coord);
+}
+
 void CSPropDiscMaterial::ShowPropertyStatus(ostream& stream)
 {
 	CSProperties::ShowPropertyStatus(stream);
@@ -487,6 +814,8 @@ void CSPropDiscMaterial::ShowPropertyStatus(ostream& stream)
 vtkPolyData* CSPropDiscMaterial::CreatePolyDataModel() const
 {
 	vtkPolyData* polydata = vtkPolyData::New();
+	if ((m_Disc_Ind==NULL) || !(m_mesh[0] && m_mesh[1] && m_mesh[2]))
+		return polydata;
 	vtkCellArray *poly = vtkCellArray::New();
 	vtkPoints *points = vtkPoints::New();
 
@@ -23,6 +23,7 @@
 typedef unsigned char uint8;
 
 class vtkPolyData;
+class CSRectGrid;
 
 //! Continuous Structure Discrete Material Property
 /*!
@@ -45,6 +46,9 @@ public:
 
 	virtual double GetDensityWeighted(const double* coords);
 
+	//! Get all weighted material values at once, the database position is only looked up once. \sa CSPropMaterial::GetAllWeighted
+	virtual void GetAllWeighted(const double* coords, double values[5], int ny=0);
+
 	//! Set true if database index 0 is used as background material (default), or false if CSPropMaterial should be used as index 0
 	virtual void SetUseDataBaseForBackground(bool val) {m_DB_Background=val;}
 
@@ -57,8 +61,38 @@ public:
 	virtual bool Write2XML(TiXmlNode& root, bool parameterised=true, bool sparse=false);
 	virtual bool ReadFromXML(TiXmlNode &root);
 
+	//! Set the simulation area (in drawing units of the given coordinate system), only the part of the material volume inside this area will be read.
+	void SetSimulationArea(const double area[6], CoordinateSystem cs);
+	//! Read the whole material volume (default). \sa SetSimulationArea
+	void ClearSimulationArea() {m_UseSimArea=false;}
+
+	//! Map the material index volume read-only into memory instead of reading it (if it is stored contiguous and uncompressed).
+	/*!
+	 All processes on a node mapping the same file share one physical copy of the volume. The simulation area is ignored in this mode.
+	 Currently only supported on POSIX systems, otherwise the volume is read as usual.
+	 */
+	void SetUseMemoryMap(bool val) {m_UseMemoryMap=val;}
+	bool GetUseMemoryMap() const {return m_UseMemoryMap;}
+
 	bool ReadHDF5(string filename);
 
+	//! Resample the material onto the cells of the given grid, subsequent cell queries are direct array reads.
+	/*!
+	 \param grid The grid to resample onto, must be in the same coordinate system as the structure.
+	 \param subSamples Number of samples per cell and direction. Use 1 to sample the cell centres only, otherwise the most frequent material of all samples is used (majority vote).
+	 \param numThreads Number of threads to use, the z-planes of the grid are distributed among the threads.
+	 \sa GetResampledDBPos, GetResampledWeighted
+	 */
+	bool ResampleToGrid(CSRectGrid* grid, unsigned int subSamples=1, unsigned int numThreads=1);
+	//! Release the resampled material data. \sa ResampleToGrid
+	void ClearResampledData();
+	//! Check if a resampled material is available. \sa ResampleToGrid
+	bool HasResampledData() const {return m_Resampled_DBPos.size()>0;}
+	//! Get the database position of a cell of the resampled grid. \return -1 for background material or if no resampled material is available.
+	int GetResampledDBPos(const unsigned int cell[3]) const;
+	//! Get all weighted material values of a cell of the resampled grid. \sa GetAllWeighted
+	void GetResampledWeighted(const unsigned int cell[3], double values[5], int ny=0);
+
 	virtual void ShowPropertyStatus(ostream& stream);
 
 	//! Create a vtkPolyData surface that separates the discrete material from background material
@@ -67,6 +101,12 @@ public:
 protected:
 	unsigned int GetWeightingPos(const double* coords);
 	int GetDBPos(const double* coords);
+	friend struct CSResampleWorker;
+	//! Resample every step-th z-plane of the resampled grid, beginning with the plane start. \sa ResampleToGrid
+	void ResamplePlanes(unsigned int start, unsigned int step, unsigned int subSamples);
+
+	//! Check the discrete mesh for uniform spacing to allow a direct cell lookup. \sa GetWeightingPos
+	void AnalyseMesh();
 
 	int m_FileType;
 	string m_Filename;
@@ -74,6 +114,8 @@ protected:
 	unsigned int m_DB_size;
 	uint8* m_Disc_Ind;
 	float *m_mesh[3];
+	bool m_UniformMesh[3];
+	double m_InvMeshDelta[3];
 	float *m_Disc_epsR;
 	float *m_Disc_kappa;
 	float *m_Disc_mueR;
@@ -83,6 +125,20 @@ protected:
 	bool m_DB_Background;
 	CSTransform* m_Transform;
 
-	void* ReadDataSet(string filename, string d_name, int type_id, int &rank, unsigned int &size, bool debug=false);
+	bool m_UseSimArea;
+	double m_SimArea[6];
+	CoordinateSystem m_SimArea_CS;
+	//! Get the range of cells (in each direction) that overlap the simulation area. \return false if there is no overlap.
+	bool GetSimAreaCellRange(unsigned int start[3], unsigned int stop[3]);
+
+	vector<short> m_Resampled_DBPos;
+	vector<double> m_Resampled_Lines[3];
+	CoordinateSystem m_Resampled_CS;
+
+	bool m_UseMemoryMap;
+	void* m_MappedData;
+	size_t m_MappedSize;
+	//! Free or unmap the material index volume.
+	void ReleaseIndexData();
 };
 
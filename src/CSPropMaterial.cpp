@@ -92,6 +92,15 @@ double CSPropMaterial::GetWeight(ParameterScalar &ps, const double* coords)
 	return value;
 }
 
+void CSPropMaterial::GetAllWeighted(const double* coords, double values[5], int ny)
+{
+	values[0] = GetEpsilonWeighted(ny,coords);
+	values[1] = GetKappaWeighted(ny,coords);
+	values[2] = GetMueWeighted(ny,coords);
+	values[3] = GetSigmaWeighted(ny,coords);
+	values[4] = GetDensityWeighted(coords);
+}
+
 void CSPropMaterial::Init()
 {
 	bIsotropy = true;
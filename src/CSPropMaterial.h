@@ -81,6 +81,9 @@ public:
 	const string GetDensityWeightFunction() {return WeightDensity.GetString();}
 	virtual double GetDensityWeighted(const double* coords)	{return GetWeight(WeightDensity,coords)*GetDensity();}
 
+	//! Get all weighted material values at once: epsilon, kappa, mue, sigma and density (in this order).
+	virtual void GetAllWeighted(const double* coords, double values[5], int ny=0);
+
 	void SetIsotropy(bool val) {bIsotropy=val;}
 	bool GetIsotropy() {return bIsotropy;}
 
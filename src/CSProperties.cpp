@@ -31,6 +31,8 @@
 #include "CSPropResBox.h"
 
 #include "CSPrimitives.h"
+#include "CSArena.h"
+#include "ContinuousStructure.h"
 #include <iostream>
 #include <sstream>
 #include "tinyxml.h"
@@ -50,6 +52,7 @@ CSProperties::CSProperties(CSProperties* prop)
 	{
 		vPrimitives.push_back(prop->vPrimitives.at(i));
 	}
+	m_Structure=NULL;
 	InitCoordParameter();
 }
 
@@ -68,6 +71,7 @@ CSProperties::CSProperties(ParameterSet* paraSet)
 	FillColor.a=EdgeColor.a=255;
 	bVisisble=true;
 	Type=ANY;
+	m_Structure=NULL;
 	InitCoordParameter();
 }
 
@@ -86,10 +90,21 @@ CSProperties::CSProperties(unsigned int ID, ParameterSet* paraSet)
 	FillColor.a=EdgeColor.a=255;
 	bVisisble=true;
 	Type=ANY;
+	m_Structure=NULL;
 	InitCoordParameter();
 }
 
 
+void* CSProperties::operator new(size_t size)
+{
+	return CSArena::Allocate(size);
+}
+
+void CSProperties::operator delete(void* ptr)
+{
+	CSArena::Free(ptr);
+}
+
 CSProperties::~CSProperties()
 {
 	while (vPrimitives.size()>0)
@@ -131,7 +146,13 @@ void CSProperties::SetID(unsigned int ID) {uiID=ID;}
 unsigned int CSProperties::GetUniqueID() {return UniqueID;}
 void CSProperties::SetUniqueID(unsigned int uID) {UniqueID=uID;}
 
-void CSProperties::SetName(const string name) {sName=string(name);}
+void CSProperties::SetName(const string name)
+{
+	string oldName = sName;
+	sName=string(name);
+	if (m_Structure)
+		m_Structure->IndexRenameProperty(this,oldName);
+}
 const string CSProperties::GetName() {return sName;}
 
 bool CSProperties::ExistAttribute(string name)
@@ -240,6 +261,8 @@ void CSProperties::AddPrimitive(CSPrimitives *prim)
 		return;
 	}
 	vPrimitives.push_back(prim);
+	if (m_Structure)
+		m_Structure->IndexAddPrimitive(this,prim);
 	prim->SetProperty(this);
 }
 
@@ -261,6 +284,8 @@ void CSProperties::RemovePrimitive(CSPrimitives *prim)
 		{
 			vector<CSPrimitives*>::iterator iter=vPrimitives.begin()+i;
 			vPrimitives.erase(iter);
+			if (m_Structure)
+				m_Structure->IndexRemovePrimitive(prim);
 			prim->SetProperty(NULL);
 			return;
 		}
@@ -284,6 +309,8 @@ CSPrimitives* CSProperties::TakePrimitive(size_t index)
 	CSPrimitives* prim=vPrimitives.at(index);
 	vector<CSPrimitives*>::iterator iter=vPrimitives.begin()+index;
 	vPrimitives.erase(iter);
+	if (m_Structure)
+		m_Structure->IndexRemovePrimitive(prim);
 	return prim;
 }
 
@@ -355,8 +382,8 @@ bool CSProperties::ReadFromXML(TiXmlNode &root)
 		uiID=help;
 
 	const char* cHelp=prop->Attribute("Name");
-	if (cHelp!=NULL) sName=string(cHelp);
-	else sName.clear();
+	if (cHelp!=NULL) SetName(string(cHelp));
+	else SetName(string());
 
 	TiXmlElement* FC = root.FirstChildElement("FillColor");
 	if (FC!=NULL)
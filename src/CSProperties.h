@@ -41,6 +41,7 @@
 using namespace std;
 
 class CSPrimitives;
+class ContinuousStructure;
 
 class CSPropUnknown;
 class CSPropMaterial;
@@ -73,6 +74,10 @@ class CSXCAD_EXPORT CSProperties
 {
 public:
 	virtual ~CSProperties();
+
+	//! Properties are allocated from the current arena, e.g. of the structure reading them. \sa CSArena
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
 	//! Copy constructor
 	CSProperties(CSProperties* prop);
 	//! Enumeration of all possible sub-types of this base-class
@@ -108,6 +113,11 @@ public:
 	//! Get Name for this Property. \sa SetName
 	const string GetName();
 
+	//! Set the structure owning this property, it is notified about all changes of the primitives. Used internally. \sa ContinuousStructure::AddProperty
+	void SetStructure(ContinuousStructure* csx) {m_Structure=csx;}
+	//! Get the structure owning this property, NULL if none. \sa SetStructure
+	ContinuousStructure* GetStructure() const {return m_Structure;}
+
 	//! Check if given attribute exists
 	bool ExistAttribute(string name);
 	//! Get the value of a given attribute
@@ -137,6 +147,8 @@ public:
 
 	//! Get all Primitives \sa GetPrimitive
 	vector<CSPrimitives*> GetAllPrimitives() {return vPrimitives;}
+	//! Get all Primitives without copying. The reference is invalidated if primitives are added or removed. \sa GetAllPrimitives
+	const vector<CSPrimitives*>& GetPrimitiveTable() const {return vPrimitives;}
 	
 	//! Set a fill-color for this property. \sa GetFillColor
 	void SetFillColor(RGBa color);
@@ -210,6 +222,7 @@ protected:
 	unsigned int UniqueID;
 	string sName;
 	string sType;
+	ContinuousStructure* m_Structure;
 	RGBa FillColor;
 	RGBa EdgeColor;
 
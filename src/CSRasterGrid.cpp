@@ -0,0 +1,941 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CSRasterGrid.h"
+#include "ContinuousStructure.h"
+#include "CSPropMaterial.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+#include <hdf5.h>
+#include <hdf5_hl.h>
+
+//! Blocks with up to this number of cells are classified by point tests.
+#define CSRASTERGRID_LEAF_CELLS 64
+//! Tolerance of the block tests, relative to the grid extent.
+#define CSRASTERGRID_REL_MARGIN 1e-9
+
+CSRasterGrid::CSRasterGrid(ContinuousStructure* csx)
+{
+	m_CSX = csx;
+	m_Type = CSProperties::ANY;
+	for (int n=0;n<3;++n)
+		m_NumCells[n] = 0;
+}
+
+CSRasterGrid::~CSRasterGrid()
+{
+}
+
+bool CSRasterGrid::Rasterize(CSProperties::PropertyType type)
+{
+	m_Type = type;
+	m_PropTable.clear();
+	m_Index.clear();
+	m_Fractions.clear();
+	CSRectGrid* grid = m_CSX->GetGrid();
+	for (int n=0;n<3;++n)
+	{
+		unsigned int qty = 0;
+		double* lines = grid->GetLines(n,NULL,qty);
+		m_Lines[n].assign(lines,lines+qty);
+		delete[] lines;
+		m_NumCells[n] = 0;
+		if (qty<2)
+		{
+			cerr << __func__ << ": Error, invalid grid, at least two lines in each direction are required" << endl;
+			return false;
+		}
+		m_NumCells[n] = qty-1;
+	}
+	m_Index.resize((size_t)m_NumCells[0]*m_NumCells[1]*m_NumCells[2],-1);
+
+	unsigned int start[3] = {0,0,0};
+	unsigned int stop[3] = {m_NumCells[0]-1,m_NumCells[1]-1,m_NumCells[2]-1};
+	InitCandidates();
+	RasterizeRange(start,stop);
+	TakeSnapshot();
+	return true;
+}
+
+//! Extend the box to include the given box, initialize it if found is false.
+static void AddToBox(double box[6], bool &found, const double add[6])
+{
+	for (int n=0;n<3;++n)
+	{
+		if ((found==false) || (add[2*n]<box[2*n]))
+			box[2*n] = add[2*n];
+		if ((found==false) || (add[2*n+1]>box[2*n+1]))
+			box[2*n+1] = add[2*n+1];
+	}
+	found = true;
+}
+
+bool CSRasterGrid::RasterizeModified()
+{
+	if (m_Index.size()==0)
+		return Rasterize(m_Type);
+
+	CSRectGrid* grid = m_CSX->GetGrid();
+	for (int n=0;n<3;++n)
+	{
+		unsigned int qty = 0;
+		double* lines = grid->GetLines(n,NULL,qty);
+		bool same = (qty==m_Lines[n].size()) && equal(m_Lines[n].begin(),m_Lines[n].end(),lines);
+		delete[] lines;
+		if (!same)
+			return Rasterize(m_Type);
+	}
+	// a removed property must not remain in the property table
+	for (size_t n=0;n<m_PropTable.size();++n)
+		if (m_CSX->GetIndex(m_PropTable[n])<0)
+			return Rasterize(m_Type);
+
+	InitCandidates();
+
+	// union of the old and new bounding boxes of all modified primitives
+	double dirty[6];
+	bool found = false;
+	map<CSPrimitives*, RasterSnapshot> old_snapshot;
+	old_snapshot.swap(m_Snapshot);
+	for (size_t c=0;c<m_Candidates.size();++c)
+	{
+		const RasterCandidate &cand = m_Candidates[c];
+		map<CSPrimitives*, RasterSnapshot>::iterator it = old_snapshot.find(cand.prim);
+		if (it!=old_snapshot.end())
+		{
+			const RasterSnapshot &snap = it->second;
+			bool modified = (snap.revision!=cand.prim->GetUpdateRevision()) || (snap.priority!=cand.priority) || (snap.prop!=cand.prop);
+			if (!modified)
+			{
+				old_snapshot.erase(it);
+				continue;
+			}
+			if (!snap.use_box)
+				return Rasterize(m_Type);
+			AddToBox(dirty,found,snap.box);
+			old_snapshot.erase(it);
+		}
+		if (!cand.use_box)
+			return Rasterize(m_Type);
+		AddToBox(dirty,found,cand.box);
+	}
+	// all remaining primitives have been removed
+	for (map<CSPrimitives*, RasterSnapshot>::iterator it=old_snapshot.begin();it!=old_snapshot.end();++it)
+	{
+		if (!it->second.use_box)
+			return Rasterize(m_Type);
+		AddToBox(dirty,found,it->second.box);
+	}
+
+	TakeSnapshot();
+	if (!found)
+		return true;
+
+	// all cells with a center inside the dirty region
+	unsigned int start[3], stop[3];
+	for (int n=0;n<3;++n)
+	{
+		start[n] = 0;
+		while ((start[n]<m_NumCells[n]) && (0.5*(m_Lines[n][start[n]]+m_Lines[n][start[n]+1])<dirty[2*n]-m_Margin))
+			++start[n];
+		stop[n] = m_NumCells[n];
+		while ((stop[n]>start[n]) && (0.5*(m_Lines[n][stop[n]-1]+m_Lines[n][stop[n]])>dirty[2*n+1]+m_Margin))
+			--stop[n];
+		if (stop[n]==start[n])
+			return true;
+		--stop[n];
+	}
+	m_Fractions.clear();
+	RasterizeRange(start,stop);
+	return true;
+}
+
+void CSRasterGrid::TakeSnapshot()
+{
+	m_Snapshot.clear();
+	for (size_t c=0;c<m_Candidates.size();++c)
+	{
+		const RasterCandidate &cand = m_Candidates[c];
+		RasterSnapshot &snap = m_Snapshot[cand.prim];
+		snap.revision = cand.prim->GetUpdateRevision();
+		snap.priority = cand.priority;
+		snap.prop = cand.prop;
+		snap.use_box = cand.use_box;
+		for (int n=0;n<6;++n)
+			snap.box[n] = cand.box[n];
+	}
+}
+
+CSProperties* CSRasterGrid::GetProperty(const unsigned int pos[3]) const
+{
+	int idx = GetPropertyIndex(pos);
+	if (idx<0)
+		return NULL;
+	return m_PropTable.at(idx);
+}
+
+void CSRasterGrid::GetCellCenter(const unsigned int pos[3], double center[3]) const
+{
+	for (int n=0;n<3;++n)
+		center[n] = 0.5*(m_Lines[n][pos[n]]+m_Lines[n][pos[n]+1]);
+}
+
+int CSRasterGrid::GetTableIndex(CSProperties* prop)
+{
+	for (size_t n=0;n<m_PropTable.size();++n)
+		if (m_PropTable[n]==prop)
+			return n;
+	m_PropTable.push_back(prop);
+	return m_PropTable.size()-1;
+}
+
+void CSRasterGrid::RasterizeRange(const unsigned int start[3], const unsigned int stop[3])
+{
+	vector<size_t> candidates(m_Candidates.size());
+	for (size_t n=0;n<candidates.size();++n)
+		candidates[n] = n;
+	RasterizeBlock(start,stop,candidates);
+}
+
+void CSRasterGrid::InitCandidates()
+{
+	m_Candidates.clear();
+	bool cartesian = (m_CSX->GetGrid()->GetMeshType()==CARTESIAN);
+	double extent = 0;
+	for (int n=0;n<3;++n)
+		extent = max(extent, fabs(m_Lines[n].back()-m_Lines[n].front()));
+	m_Margin = extent*CSRASTERGRID_REL_MARGIN;
+
+	// the candidates are in the same order as the primitives of the snapshot
+	m_Geometry.Freeze(m_CSX,m_Type);
+	const vector<CSProperties*> &props = m_Geometry.GetPropertyTable();
+	for (size_t i=0;i<m_Geometry.GetQtyPrimitives();++i)
+	{
+		RasterCandidate cand;
+		cand.prim = m_Geometry.GetPrimitive(i);
+		cand.prop = props.at(m_Geometry.GetPropertyIndex(i));
+		cand.priority = m_Geometry.GetPriority(i);
+		cand.use_box = false;
+		for (int n=0;n<6;++n)
+			cand.box[n] = 0;
+		cand.use_dist = cartesian && (cand.prim->GetCoordInputType()==CARTESIAN);
+		if (cand.use_dist)
+			cand.use_box = m_Geometry.GetBoundBox(i,cand.box);
+		m_Candidates.push_back(cand);
+	}
+}
+
+void CSRasterGrid::FillBlock(const unsigned int start[3], const unsigned int stop[3], int idx)
+{
+	unsigned int pos[3];
+	for (pos[2]=start[2];pos[2]<=stop[2];++pos[2])
+		for (pos[1]=start[1];pos[1]<=stop[1];++pos[1])
+		{
+			pos[0] = start[0];
+			size_t lin = GetLinearIndex(pos);
+			std::fill(m_Index.begin()+lin, m_Index.begin()+lin+(stop[0]-start[0]+1), idx);
+		}
+}
+
+void CSRasterGrid::RasterizeBlock(const unsigned int start[3], const unsigned int stop[3], const vector<size_t> &candidates)
+{
+	// the block is represented by the box spanned by its cell centers
+	double lo[3], hi[3], center[3];
+	double radius = 0;
+	size_t num_cells = 1;
+	for (int n=0;n<3;++n)
+	{
+		lo[n] = 0.5*(m_Lines[n][start[n]]+m_Lines[n][start[n]+1]);
+		hi[n] = 0.5*(m_Lines[n][stop[n]]+m_Lines[n][stop[n]+1]);
+		center[n] = 0.5*(lo[n]+hi[n]);
+		radius += 0.25*(hi[n]-lo[n])*(hi[n]-lo[n]);
+		num_cells *= stop[n]-start[n]+1;
+	}
+	radius = sqrt(radius) + m_Margin;
+
+	// the winner is the first primitive (in search order) of highest priority that encloses the whole block
+	int winner = -1;
+	vector<size_t> partial;
+	for (size_t c=0;c<candidates.size();++c)
+	{
+		const RasterCandidate &cand = m_Candidates[candidates[c]];
+		// a later primitive needs a higher priority to beat the winner
+		if ((winner>=0) && (cand.priority<=m_Candidates[winner].priority))
+			continue;
+		if (cand.use_box)
+		{
+			bool outside = false;
+			for (int n=0;n<3;++n)
+				outside |= (cand.box[2*n+1]<lo[n]-m_Margin) || (cand.box[2*n]>hi[n]+m_Margin);
+			if (outside)
+				continue;
+		}
+		double dist;
+		if (cand.use_dist && m_Geometry.GetSignedDistance(candidates[c],center,dist))
+		{
+			if (dist>radius)
+				continue;
+			if (dist<-radius)
+			{
+				winner = candidates[c];
+				continue;
+			}
+		}
+		partial.push_back(candidates[c]);
+	}
+
+	// remove all partial candidates that can not beat the winner
+	if (winner>=0)
+	{
+		vector<size_t> remaining;
+		for (size_t c=0;c<partial.size();++c)
+		{
+			int prio = m_Candidates[partial[c]].priority;
+			int win_prio = m_Candidates[winner].priority;
+			if ((prio>win_prio) || ((prio==win_prio) && (partial[c]<(size_t)winner)))
+				remaining.push_back(partial[c]);
+		}
+		partial.swap(remaining);
+	}
+
+	int win_idx = (winner<0) ? -1 : GetTableIndex(m_Candidates[winner].prop);
+	if (partial.size()==0)
+	{
+		FillBlock(start,stop,win_idx);
+		return;
+	}
+
+	if (num_cells<=CSRASTERGRID_LEAF_CELLS)
+	{
+		// batch point test of all cells against the remaining candidates only
+		double x[CSRASTERGRID_LEAF_CELLS], y[CSRASTERGRID_LEAF_CELLS], z[CSRASTERGRID_LEAF_CELLS];
+		bool inside[CSRASTERGRID_LEAF_CELLS];
+		int found[CSRASTERGRID_LEAF_CELLS];
+		unsigned int pos[3];
+		double coord[3];
+		size_t num = 0;
+		for (pos[2]=start[2];pos[2]<=stop[2];++pos[2])
+			for (pos[1]=start[1];pos[1]<=stop[1];++pos[1])
+				for (pos[0]=start[0];pos[0]<=stop[0];++pos[0])
+				{
+					GetCellCenter(pos,coord);
+					x[num] = coord[0];
+					y[num] = coord[1];
+					z[num] = coord[2];
+					found[num] = -1;
+					++num;
+				}
+		for (size_t c=0;c<partial.size();++c)
+		{
+			const RasterCandidate &cand = m_Candidates[partial[c]];
+			m_Geometry.IsInsideBatch(partial[c],num,x,y,z,inside);
+			for (size_t i=0;i<num;++i)
+				if (inside[i] && ((found[i]<0) || (cand.priority>m_Candidates[found[i]].priority)))
+					found[i] = partial[c];
+		}
+
+		CSProperties* last_prop = NULL;
+		int last_idx = -1;
+		num = 0;
+		for (pos[2]=start[2];pos[2]<=stop[2];++pos[2])
+			for (pos[1]=start[1];pos[1]<=stop[1];++pos[1])
+				for (pos[0]=start[0];pos[0]<=stop[0];++pos[0],++num)
+				{
+					if (found[num]<0)
+					{
+						m_Index[GetLinearIndex(pos)] = win_idx;
+						continue;
+					}
+					// neighboring cells mostly share the same property, avoid the table search
+					if (m_Candidates[found[num]].prop!=last_prop)
+					{
+						last_prop = m_Candidates[found[num]].prop;
+						last_idx = GetTableIndex(last_prop);
+					}
+					m_Index[GetLinearIndex(pos)] = last_idx;
+				}
+		return;
+	}
+
+	// the winner has to be tested again in the sub-blocks, keep the search order
+	if (winner>=0)
+		partial.insert(lower_bound(partial.begin(),partial.end(),(size_t)winner),(size_t)winner);
+
+	// split the block in all directions with more than one cell
+	unsigned int sub_start[2][3], sub_stop[2][3];
+	unsigned int num_sub[3];
+	for (int n=0;n<3;++n)
+	{
+		unsigned int mid = (start[n]+stop[n])/2;
+		sub_start[0][n] = start[n];
+		sub_stop[0][n] = mid;
+		sub_start[1][n] = mid+1;
+		sub_stop[1][n] = stop[n];
+		num_sub[n] = (stop[n]>start[n]) ? 2 : 1;
+	}
+	unsigned int s_start[3], s_stop[3];
+	for (unsigned int k=0;k<num_sub[2];++k)
+		for (unsigned int j=0;j<num_sub[1];++j)
+			for (unsigned int i=0;i<num_sub[0];++i)
+			{
+				unsigned int sub[3] = {i,j,k};
+				for (int n=0;n<3;++n)
+				{
+					s_start[n] = sub_start[sub[n]][n];
+					s_stop[n] = sub_stop[sub[n]][n];
+				}
+				RasterizeBlock(s_start,s_stop,partial);
+			}
+}
+
+int CSRasterGrid::ClassifyPoint(const double coord[3])
+{
+	int idx = m_Geometry.Classify(coord);
+	if (idx<0)
+		return -1;
+	return GetTableIndex(m_Geometry.GetPropertyTable().at(idx));
+}
+
+double CSRasterGrid::GetVolume(const double lo[3], const double hi[3]) const
+{
+	if (m_CSX->GetGrid()->GetMeshType()==CYLINDRICAL)
+		return 0.5*(hi[0]*hi[0]-lo[0]*lo[0])*(hi[1]-lo[1])*(hi[2]-lo[2]);
+	return (hi[0]-lo[0])*(hi[1]-lo[1])*(hi[2]-lo[2]);
+}
+
+bool CSRasterGrid::CalcBoxFractions(const double lo[3], const double hi[3], map<int,double> &volumes, const vector<size_t> &candidates)
+{
+	if (m_CSX->GetGrid()->GetMeshType()!=CARTESIAN)
+		return false;
+
+	// split the cell at all box faces, every part is then either fully inside or outside of each box
+	vector<double> cuts[3];
+	for (int n=0;n<3;++n)
+	{
+		cuts[n].push_back(lo[n]);
+		cuts[n].push_back(hi[n]);
+	}
+	double bb[6];
+	for (size_t c=0;c<candidates.size();++c)
+	{
+		size_t i = candidates[c];
+		const RasterCandidate &cand = m_Candidates[i];
+		// a candidate without a box may overlap the cell
+		if (cand.use_box==false)
+			return false;
+		bool overlap = true;
+		for (int n=0;n<3;++n)
+			overlap &= (cand.box[2*n]<=hi[n]) && (cand.box[2*n+1]>=lo[n]);
+		if (overlap==false)
+			continue;
+		// boxes and multi-boxes without transformation only
+		if ((m_Geometry.GetShapeType(i)!=CSGeometrySnapshot::SHAPE_BOX) || m_Geometry.HasTransform(i))
+			return false;
+		for (size_t k=0;k<m_Geometry.GetQtyBoxes(i);++k)
+		{
+			m_Geometry.GetBox(i,k,bb);
+			for (int n=0;n<3;++n)
+				for (int m=0;m<2;++m)
+					if ((bb[2*n+m]>lo[n]) && (bb[2*n+m]<hi[n]))
+						cuts[n].push_back(bb[2*n+m]);
+		}
+	}
+	for (int n=0;n<3;++n)
+	{
+		sort(cuts[n].begin(),cuts[n].end());
+		cuts[n].erase(unique(cuts[n].begin(),cuts[n].end()),cuts[n].end());
+	}
+
+	double p_lo[3], p_hi[3], center[3];
+	for (size_t k=0;k<cuts[2].size()-1;++k)
+		for (size_t j=0;j<cuts[1].size()-1;++j)
+			for (size_t i=0;i<cuts[0].size()-1;++i)
+			{
+				size_t pos[3] = {i,j,k};
+				for (int n=0;n<3;++n)
+				{
+					p_lo[n] = cuts[n][pos[n]];
+					p_hi[n] = cuts[n][pos[n]+1];
+					center[n] = 0.5*(p_lo[n]+p_hi[n]);
+				}
+				volumes[ClassifyPoint(center)] += GetVolume(p_lo,p_hi);
+			}
+	return true;
+}
+
+void CSRasterGrid::GetMixedCandidates(double z_lo, double z_hi, vector<size_t> &candidates) const
+{
+	candidates.clear();
+	for (size_t c=0;c<m_Candidates.size();++c)
+	{
+		const RasterCandidate &cand = m_Candidates[c];
+		if (cand.use_box)
+		{
+			if ((cand.box[4]<=z_hi) && (cand.box[5]>=z_lo))
+				candidates.push_back(c);
+		}
+		else
+			candidates.push_back(c);
+	}
+}
+
+bool CSRasterGrid::IsCellMixed(const double lo[3], const double hi[3], const vector<size_t> &candidates) const
+{
+	double center[3];
+	double half_diag = 0;
+	for (int n=0;n<3;++n)
+	{
+		center[n] = 0.5*(lo[n]+hi[n]);
+		half_diag += 0.25*(hi[n]-lo[n])*(hi[n]-lo[n]);
+	}
+	half_diag = sqrt(half_diag);
+	for (size_t c=0;c<candidates.size();++c)
+	{
+		const RasterCandidate &cand = m_Candidates[candidates[c]];
+		if (cand.use_box)
+		{
+			bool overlap = true, cover = true;
+			for (int n=0;n<3;++n)
+			{
+				overlap &= (cand.box[2*n]<=hi[n]) && (cand.box[2*n+1]>=lo[n]);
+				cover &= (cand.box[2*n]<=lo[n]) && (cand.box[2*n+1]>=hi[n]);
+			}
+			if (overlap==false)
+				continue;
+			if (cover==false)
+				return true;
+		}
+		double dist;
+		if (cand.use_dist && m_Geometry.GetSignedDistance(candidates[c],center,dist) && (fabs(dist)<half_diag))
+			return true;
+	}
+	return false;
+}
+
+void CSRasterGrid::SampleFractions(const double lo[3], const double hi[3], unsigned int level, map<int,double> &volumes, const vector<size_t> &candidates)
+{
+	double center[3], corner[3];
+	for (int n=0;n<3;++n)
+		center[n] = 0.5*(lo[n]+hi[n]);
+	int idx[9];
+	idx[8] = ClassifyPoint(center);
+	bool uniform = true;
+	for (int c=0;c<8;++c)
+	{
+		for (int n=0;n<3;++n)
+			corner[n] = (c & (1<<n)) ? hi[n] : lo[n];
+		idx[c] = ClassifyPoint(corner);
+		uniform &= (idx[c]==idx[8]);
+	}
+	double vol = GetVolume(lo,hi);
+	// a thin or small primitive may be missed by all corners and the center, bisect as long as possible
+	if (uniform && ((level==0) || (IsCellMixed(lo,hi,candidates)==false)))
+	{
+		volumes[idx[8]] += vol;
+		return;
+	}
+	if (level==0)
+	{
+		// finest level, weight the center with 1/2 and every corner with 1/16
+		volumes[idx[8]] += 0.5*vol;
+		for (int c=0;c<8;++c)
+			volumes[idx[c]] += vol/16.0;
+		return;
+	}
+	double s_lo[3], s_hi[3];
+	for (int c=0;c<8;++c)
+	{
+		for (int n=0;n<3;++n)
+		{
+			s_lo[n] = (c & (1<<n)) ? center[n] : lo[n];
+			s_hi[n] = (c & (1<<n)) ? hi[n] : center[n];
+		}
+		SampleFractions(s_lo,s_hi,level-1,volumes,candidates);
+	}
+}
+
+bool CSRasterGrid::CalcVolumeFractions(unsigned int maxLevel)
+{
+	m_Fractions.clear();
+	if (m_Index.size()==0)
+	{
+		cerr << __func__ << ": Error, no rasterized data available" << endl;
+		return false;
+	}
+	// the structure was modified since the last classification, the cells and the snapshot have to be brought up to date first
+	if ((m_Geometry.IsCurrent()==false) && (RasterizeModified()==false))
+		return false;
+
+	// classify the grid nodes plane by plane
+	size_t plane_size = m_Lines[0].size()*m_Lines[1].size();
+	vector<int> nodes[2];
+	size_t row_size = m_Lines[0].size();
+	vector<double> row_y(row_size), row_z(row_size);
+	vector<int> row_idx(row_size);
+	unsigned int pos[3];
+	for (pos[2]=0;pos[2]<m_Lines[2].size();++pos[2])
+	{
+		nodes[0].swap(nodes[1]);
+		nodes[1].resize(plane_size);
+		// every row of nodes is classified at once on the geometry snapshot
+		std::fill(row_z.begin(),row_z.end(),m_Lines[2][pos[2]]);
+		for (pos[1]=0;pos[1]<m_Lines[1].size();++pos[1])
+		{
+			std::fill(row_y.begin(),row_y.end(),m_Lines[1][pos[1]]);
+			m_Geometry.ClassifyBatch(row_size,&m_Lines[0][0],&row_y[0],&row_z[0],&row_idx[0]);
+			for (pos[0]=0;pos[0]<row_size;++pos[0])
+			{
+				int idx = row_idx[pos[0]];
+				nodes[1][pos[0]+row_size*pos[1]] = (idx<0) ? -1 : GetTableIndex(m_Geometry.GetPropertyTable().at(idx));
+			}
+		}
+		if (pos[2]==0)
+			continue;
+
+		// all cells between the last two node planes
+		unsigned int cell[3];
+		cell[2] = pos[2]-1;
+		double lo[3], hi[3];
+		lo[2] = m_Lines[2][cell[2]];
+		hi[2] = m_Lines[2][cell[2]+1];
+		vector<size_t> plane_cands;
+		GetMixedCandidates(lo[2],hi[2],plane_cands);
+		for (cell[1]=0;cell[1]<m_NumCells[1];++cell[1])
+			for (cell[0]=0;cell[0]<m_NumCells[0];++cell[0])
+			{
+				for (int n=0;n<2;++n)
+				{
+					lo[n] = m_Lines[n][cell[n]];
+					hi[n] = m_Lines[n][cell[n]+1];
+				}
+				int center_idx = m_Index[GetLinearIndex(cell)];
+				bool uniform = true;
+				for (int c=0;(c<8) && uniform;++c)
+				{
+					size_t node = cell[0] + ((c&1)?1:0) + m_Lines[0].size()*(cell[1] + ((c&2)?1:0));
+					uniform = (nodes[(c&4)?1:0][node]==center_idx);
+				}
+				// a thin or small primitive may be missed by all nodes and the center
+				if (uniform && (IsCellMixed(lo,hi,plane_cands)==false))
+					continue;
+				map<int,double> volumes;
+				if (CalcBoxFractions(lo,hi,volumes,plane_cands)==false)
+				{
+					volumes.clear();
+					SampleFractions(lo,hi,maxLevel,volumes,plane_cands);
+				}
+				double cell_vol = GetVolume(lo,hi);
+				vector<pair<int,float> > &fractions = m_Fractions[GetLinearIndex(cell)];
+				for (map<int,double>::const_iterator it=volumes.begin();it!=volumes.end();++it)
+					if (it->second>0)
+						fractions.push_back(pair<int,float>(it->first,it->second/cell_vol));
+			}
+	}
+	return true;
+}
+
+unsigned int CSRasterGrid::GetVolumeFractions(const unsigned int pos[3], vector<int> &index, vector<double> &fraction) const
+{
+	index.clear();
+	fraction.clear();
+	size_t cell = GetLinearIndex(pos);
+	map<size_t, vector<pair<int,float> > >::const_iterator it = m_Fractions.find(cell);
+	if (it==m_Fractions.end())
+	{
+		index.push_back(m_Index[cell]);
+		fraction.push_back(1.0);
+		return 1;
+	}
+	for (size_t n=0;n<it->second.size();++n)
+	{
+		index.push_back(it->second.at(n).first);
+		fraction.push_back(it->second.at(n).second);
+	}
+	return index.size();
+}
+
+void CSRasterGrid::GetCellMaterial(const unsigned int pos[3], double values[4][3]) const
+{
+	CSProperties* prop = GetProperty(pos);
+	CSPropMaterial* mat = prop ? prop->ToMaterial() : NULL;
+	if (mat==NULL)
+	{
+		CSBackgroundMaterial* bg = m_CSX->GetBackgroundMaterial();
+		for (int ny=0;ny<3;++ny)
+		{
+			values[0][ny] = bg->GetEpsilon();
+			values[1][ny] = bg->GetMue();
+			values[2][ny] = bg->GetKappa();
+			values[3][ny] = bg->GetSigma();
+		}
+		return;
+	}
+	double center[3];
+	GetCellCenter(pos,center);
+	double all[5];
+	for (int ny=0;ny<3;++ny)
+	{
+		mat->GetAllWeighted(center,all,ny);
+		values[0][ny] = all[0];
+		values[1][ny] = all[2];
+		values[2][ny] = all[1];
+		values[3][ny] = all[3];
+	}
+}
+
+//! Create a dataset chunked by slabs of the first dimension.
+static hid_t CreateSlabDataSet(hid_t loc_id, const char* name, hid_t type_id, int rank, const hsize_t* dims, int compression)
+{
+	hsize_t chunk[4];
+	chunk[0] = 1;
+	for (int n=1;n<rank;++n)
+		chunk[n] = dims[n];
+	hid_t space_id = H5Screate_simple(rank, dims, NULL);
+	hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(plist_id, rank, chunk);
+	if ((compression>0) && (H5Zfilter_avail(H5Z_FILTER_DEFLATE)>0))
+		H5Pset_deflate(plist_id, compression);
+	hid_t ds_id = H5Dcreate2(loc_id, name, type_id, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
+	H5Pclose(plist_id);
+	H5Sclose(space_id);
+	return ds_id;
+}
+
+//! Write the slab n of the first dimension.
+static bool WriteSlab(hid_t ds_id, hid_t mem_type_id, int rank, const hsize_t* dims, hsize_t n, const void* data)
+{
+	hsize_t start[4] = {n,0,0,0};
+	hsize_t count[4];
+	count[0] = 1;
+	for (int i=1;i<rank;++i)
+		count[i] = dims[i];
+	hid_t file_space = H5Dget_space(ds_id);
+	H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
+	hid_t mem_space = H5Screate_simple(rank, count, NULL);
+	herr_t err = H5Dwrite(ds_id, mem_type_id, mem_space, file_space, H5P_DEFAULT, data);
+	H5Sclose(mem_space);
+	H5Sclose(file_space);
+	return (err>=0);
+}
+
+bool CSRasterGrid::Write2HDF5(const char* file, int compression) const
+{
+	if (m_Index.size()==0)
+	{
+		cerr << __func__ << ": Error, no rasterized data available" << endl;
+		return false;
+	}
+	hid_t file_id = H5Fcreate(file, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	if (file_id<0)
+	{
+		cerr << __func__ << ": Error, failed to create file: " << file << endl;
+		return false;
+	}
+
+	bool ok = true;
+	hid_t group_id = H5Gcreate2(file_id, "/Mesh", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	const char* line_names[] = {"x","y","z"};
+	for (int n=0;n<3;++n)
+	{
+		hsize_t dims[1] = {m_Lines[n].size()};
+		ok &= H5LTmake_dataset_double(group_id, line_names[n], 1, dims, &m_Lines[n][0])>=0;
+	}
+	double unit = m_CSX->GetGrid()->GetDeltaUnit();
+	ok &= H5LTset_attribute_double(file_id, "/Mesh", "DeltaUnit", &unit, 1)>=0;
+	int meshType = m_CSX->GetGrid()->GetMeshType();
+	ok &= H5LTset_attribute_int(file_id, "/Mesh", "MeshType", &meshType, 1)>=0;
+	H5Gclose(group_id);
+
+	// property table
+	group_id = H5Gcreate2(file_id, "/PropertyTable", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	if (m_PropTable.size()>0)
+	{
+		hsize_t dims[1] = {m_PropTable.size()};
+		vector<int> ids(m_PropTable.size());
+		vector<int> types(m_PropTable.size());
+		size_t max_len = 1;
+		for (size_t n=0;n<m_PropTable.size();++n)
+		{
+			ids.at(n) = m_PropTable.at(n)->GetID();
+			types.at(n) = m_PropTable.at(n)->GetType();
+			max_len = max(max_len,m_PropTable.at(n)->GetName().size()+1);
+		}
+		ok &= H5LTmake_dataset_int(group_id, "ID", 1, dims, &ids[0])>=0;
+		ok &= H5LTmake_dataset_int(group_id, "Type", 1, dims, &types[0])>=0;
+
+		vector<char> names(max_len*m_PropTable.size(),0);
+		for (size_t n=0;n<m_PropTable.size();++n)
+		{
+			string name = m_PropTable.at(n)->GetName();
+			memcpy(&names[n*max_len], name.c_str(), name.size());
+		}
+		hid_t str_type = H5Tcopy(H5T_C_S1);
+		H5Tset_size(str_type, max_len);
+		ok &= H5LTmake_dataset(group_id, "Name", 1, dims, str_type, &names[0])>=0;
+		H5Tclose(str_type);
+	}
+	H5Gclose(group_id);
+
+	// cell data, dimensions are {z,y,x} with x as the fastest running index
+	hsize_t dims[4] = {m_NumCells[2], m_NumCells[1], m_NumCells[0], 3};
+	hid_t idx_id = CreateSlabDataSet(file_id, "/PropertyIndex", H5T_NATIVE_INT, 3, dims, compression);
+	const char* mat_names[] = {"/Epsilon","/Mue","/Kappa","/Sigma"};
+	hid_t mat_id[4];
+	for (int m=0;m<4;++m)
+	{
+		mat_id[m] = CreateSlabDataSet(file_id, mat_names[m], H5T_NATIVE_FLOAT, 4, dims, compression);
+		ok &= (mat_id[m]>=0);
+	}
+	ok &= (idx_id>=0);
+
+	size_t slab_size = (size_t)m_NumCells[0]*m_NumCells[1];
+	vector<float> slab[4];
+	for (int m=0;m<4;++m)
+		slab[m].resize(3*slab_size);
+	double values[4][3];
+	unsigned int pos[3];
+	for (pos[2]=0;(pos[2]<m_NumCells[2]) && ok;++pos[2])
+	{
+		ok &= WriteSlab(idx_id, H5T_NATIVE_INT, 3, dims, pos[2], &m_Index[pos[2]*slab_size]);
+		size_t n = 0;
+		for (pos[1]=0;pos[1]<m_NumCells[1];++pos[1])
+			for (pos[0]=0;pos[0]<m_NumCells[0];++pos[0],++n)
+			{
+				GetCellMaterial(pos,values);
+				for (int m=0;m<4;++m)
+					for (int ny=0;ny<3;++ny)
+						slab[m][3*n+ny] = values[m][ny];
+			}
+		for (int m=0;m<4;++m)
+			ok &= WriteSlab(mat_id[m], H5T_NATIVE_FLOAT, 4, dims, pos[2], &slab[m][0]);
+	}
+
+	if (idx_id>=0)
+		H5Dclose(idx_id);
+	for (int m=0;m<4;++m)
+		if (mat_id[m]>=0)
+			H5Dclose(mat_id[m]);
+	H5Fclose(file_id);
+	if (ok==false)
+		cerr << __func__ << ": Error, failed to write file: " << file << endl;
+	return ok;
+}
+
+//! Write binary data in big endian byte order, as required by the legacy VTK file format.
+template <typename T> static bool WriteBigEndian(FILE* fp, const T* data, size_t num)
+{
+	const unsigned short test = 1;
+	if (*((const unsigned char*)&test)==0)
+		return fwrite(data, sizeof(T), num, fp)==num;
+	vector<unsigned char> buf(num*sizeof(T));
+	const unsigned char* src = (const unsigned char*)data;
+	for (size_t n=0;n<num;++n)
+		for (size_t b=0;b<sizeof(T);++b)
+			buf[n*sizeof(T)+b] = src[n*sizeof(T)+sizeof(T)-1-b];
+	return fwrite(&buf[0], 1, buf.size(), fp)==buf.size();
+}
+
+bool CSRasterGrid::Write2VTK(const char* file) const
+{
+	if (m_Index.size()==0)
+	{
+		cerr << __func__ << ": Error, no rasterized data available" << endl;
+		return false;
+	}
+	FILE* fp = fopen(file,"wb");
+	if (fp==NULL)
+	{
+		cerr << __func__ << ": Error, failed to create file: " << file << endl;
+		return false;
+	}
+
+	bool ok = true;
+	fprintf(fp, "# vtk DataFile Version 3.0\n");
+	fprintf(fp, "%s\n", ContinuousStructure::GetInfoLine(true).c_str());
+	fprintf(fp, "BINARY\nDATASET RECTILINEAR_GRID\n");
+	fprintf(fp, "DIMENSIONS %u %u %u\n", (unsigned int)m_Lines[0].size(), (unsigned int)m_Lines[1].size(), (unsigned int)m_Lines[2].size());
+	const char* coord_names[] = {"X_COORDINATES","Y_COORDINATES","Z_COORDINATES"};
+	for (int n=0;n<3;++n)
+	{
+		fprintf(fp, "%s %u double\n", coord_names[n], (unsigned int)m_Lines[n].size());
+		ok &= WriteBigEndian(fp, &m_Lines[n][0], m_Lines[n].size());
+		fprintf(fp, "\n");
+	}
+
+	fprintf(fp, "CELL_DATA %lu\n", (unsigned long)m_Index.size());
+	fprintf(fp, "SCALARS PropertyIndex int 1\nLOOKUP_TABLE default\n");
+	ok &= WriteBigEndian(fp, &m_Index[0], m_Index.size());
+	fprintf(fp, "\n");
+
+	// the material values are evaluated only once per cell, slab by slab
+	// the arrays are written one after another, all but the first are buffered in temporary files
+	const char* mat_names[] = {"Epsilon","Mue","Kappa","Sigma"};
+	size_t slab_size = (size_t)m_NumCells[0]*m_NumCells[1];
+	vector<float> slab[4];
+	FILE* tmp[4] = {fp,NULL,NULL,NULL};
+	for (int m=0;m<4;++m)
+	{
+		slab[m].resize(3*slab_size);
+		if (m>0)
+			tmp[m] = tmpfile();
+		ok &= (tmp[m]!=NULL);
+	}
+	double values[4][3];
+	unsigned int pos[3];
+	fprintf(fp, "VECTORS %s float\n", mat_names[0]);
+	for (pos[2]=0;(pos[2]<m_NumCells[2]) && ok;++pos[2])
+	{
+		size_t n = 0;
+		for (pos[1]=0;pos[1]<m_NumCells[1];++pos[1])
+			for (pos[0]=0;pos[0]<m_NumCells[0];++pos[0],++n)
+			{
+				GetCellMaterial(pos,values);
+				for (int m=0;m<4;++m)
+					for (int ny=0;ny<3;++ny)
+						slab[m][3*n+ny] = values[m][ny];
+			}
+		for (int m=0;m<4;++m)
+			ok &= WriteBigEndian(tmp[m], &slab[m][0], slab[m].size());
+	}
+	fprintf(fp, "\n");
+	vector<char> buffer(1<<16);
+	for (int m=1;m<4;++m)
+	{
+		if (tmp[m]==NULL)
+			continue;
+		if (ok)
+		{
+			fprintf(fp, "VECTORS %s float\n", mat_names[m]);
+			rewind(tmp[m]);
+			size_t len;
+			while ((len=fread(&buffer[0],1,buffer.size(),tmp[m]))>0)
+				ok &= (fwrite(&buffer[0],1,len,fp)==len);
+			ok &= (ferror(tmp[m])==0);
+			fprintf(fp, "\n");
+		}
+		fclose(tmp[m]);
+	}
+
+	ok &= (fclose(fp)==0);
+	if (ok==false)
+		cerr << __func__ << ": Error, failed to write file: " << file << endl;
+	return ok;
+}
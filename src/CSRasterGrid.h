@@ -0,0 +1,189 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSRASTERGRID_H
+#define CSRASTERGRID_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include "CSXCAD_Global.h"
+#include "CSProperties.h"
+#include "CSGeometrySnapshot.h"
+
+class ContinuousStructure;
+
+//! Property classification of all cells of the rectilinear grid of a structure.
+/*!
+ Every cell of the grid is assigned the property of highest priority found at the cell center (see ContinuousStructure::GetPropertyByCoordPriority).
+ The cells are classified hierarchically: the index space is subdivided recursively and every block that is found to be fully inside
+ a winning primitive or outside of all primitives (using bounding boxes and CSGeometrySnapshot::GetSignedDistance) is filled without any point test.
+ All point tests are done on a frozen CSGeometrySnapshot of the structure.
+ The result can be exported to HDF5 and VTK, including the material values of every cell.
+ */
+class CSXCAD_EXPORT CSRasterGrid
+{
+public:
+	CSRasterGrid(ContinuousStructure* csx);
+	virtual ~CSRasterGrid();
+
+	//! Classify all cells of the current grid of the structure.
+	/*!
+	 \param type Property type(s) of interest, e.g. CSProperties::MATERIAL.
+	 \return false if the grid is invalid.
+	 */
+	virtual bool Rasterize(CSProperties::PropertyType type=CSProperties::ANY);
+	//! Update the classification after primitives have been modified, added or removed, requires Rasterize.
+	/*!
+	 Only the cells inside the union of the old and new bounding boxes of all modified primitives are classified again.
+	 A primitive is considered modified if it was updated (see CSPrimitives::GetUpdateRevision) or its priority or property has changed.
+	 Everything is classified again if the grid has changed, a property was removed or a modified primitive has no conservative bounding box (e.g. in a non-cartesian mesh).
+	 The volume fractions are discarded if any cell was updated.
+	 \return false if the grid is invalid.
+	 */
+	virtual bool RasterizeModified();
+
+	//! Get the number of cells in the given direction.
+	unsigned int GetNumCells(int ny) const {return m_NumCells[ny];}
+	//! Get the total number of cells.
+	size_t GetNumCells() const {return m_Index.size();}
+	//! Get the mesh lines used for the classification.
+	const vector<double>& GetLines(int ny) const {return m_Lines[ny];}
+
+	//! Get the index into the property table for the given cell, -1 if no property was found (background).
+	int GetPropertyIndex(const unsigned int pos[3]) const {return m_Index[GetLinearIndex(pos)];}
+	//! Get the property for the given cell, NULL if no property was found (background).
+	CSProperties* GetProperty(const unsigned int pos[3]) const;
+	//! Get all properties found, the index of a cell refers to this table.
+	const vector<CSProperties*>& GetPropertyTable() const {return m_PropTable;}
+
+	//! Calculate the volume fraction of all properties for every cell, requires Rasterize.
+	/*!
+	 If the structure was modified since the last classification, RasterizeModified is called first.
+	 A cell is considered uniform, if its corners and its center belong to the same property and no primitive boundary may cross the cell,
+	 i.e. no bounding box overlaps the cell only partially and no signed distance at the cell center is smaller than the half cell diagonal.
+	 All other cells are resolved exactly, if only axis-aligned boxes (without transformation) are involved in a cartesian mesh.
+	 Otherwise an adaptive sampling is used, bisecting non-uniform parts of a cell up to maxLevel times.
+	 \sa GetVolumeFractions
+	 */
+	bool CalcVolumeFractions(unsigned int maxLevel=3);
+	//! Get the volume fractions of a cell. The volume fractions have to be calculated first, otherwise the cell is treated as uniform.
+	/*!
+	 \param pos The cell position.
+	 \param index The found properties as index into the property table, -1 for background.
+	 \param fraction The volume fraction for each found property.
+	 \return The number of found properties.
+	 */
+	unsigned int GetVolumeFractions(const unsigned int pos[3], vector<int> &index, vector<double> &fraction) const;
+	//! Get the number of non-uniform cells found by CalcVolumeFractions.
+	size_t GetNumMixedCells() const {return m_Fractions.size();}
+
+	//! Get the material values of a cell, the background material is used for all non-material properties.
+	/*!
+	 \param pos The cell position.
+	 \param values Epsilon, mue, kappa and sigma for all three directions.
+	 */
+	void GetCellMaterial(const unsigned int pos[3], double values[4][3]) const;
+
+	//! Write the classification and the material values to a HDF5 file.
+	/*!
+	 The datasets are written slab by slab (in z-direction) and stored chunked and compressed:
+	 "/Mesh/x,y,z" the mesh lines, "/PropertyIndex" the cell index into the property table, "/Epsilon", "/Mue", "/Kappa", "/Sigma" the material values of all three directions.
+	 The property table is stored in the group "/PropertyTable" (ID, Type and Name of all properties).
+	 \param file Filename to write into. Will create a new file or overwrite an existing one!
+	 \param compression The deflate compression level (0-9), 0 disables the compression.
+	 */
+	bool Write2HDF5(const char* file, int compression=6) const;
+	//! Write the classification and the material values to a legacy binary VTK rectilinear grid file.
+	/*!
+	 The cell data is written slab by slab (in z-direction). The mesh lines are written as given, e.g. a cylindrical mesh is not converted.
+	 */
+	bool Write2VTK(const char* file) const;
+
+protected:
+	ContinuousStructure* m_CSX;
+	CSProperties::PropertyType m_Type;
+	vector<double> m_Lines[3];
+	vector<int> m_Index;
+	vector<CSProperties*> m_PropTable;
+	unsigned int m_NumCells[3];
+
+	//! Primitive to be tested during the hierarchical classification. \sa RasterizeBlock
+	struct RasterCandidate
+	{
+		CSPrimitives* prim;
+		CSProperties* prop;
+		int priority;
+		//! The bounding box is conservative and can be used to cull blocks.
+		bool use_box;
+		//! The signed distance is available in the coordinates of the grid.
+		bool use_dist;
+		double box[6];
+	};
+	//! All primitives of interest, in the order of the priority search of ContinuousStructure::GetPropertyByCoordPriority.
+	vector<RasterCandidate> m_Candidates;
+	//! Frozen geometry of all primitives of interest, the n-th candidate is the n-th primitive of the snapshot. \sa InitCandidates
+	CSGeometrySnapshot m_Geometry;
+	//! Absolute tolerance for the block tests.
+	double m_Margin;
+
+	//! State of a primitive at the time of the last classification. \sa RasterizeModified
+	struct RasterSnapshot
+	{
+		unsigned int revision;
+		int priority;
+		CSProperties* prop;
+		bool use_box;
+		double box[6];
+	};
+	map<CSPrimitives*, RasterSnapshot> m_Snapshot;
+	//! Store the current state of all candidates. \sa m_Snapshot
+	void TakeSnapshot();
+
+	//! Volume fractions of all non-uniform cells, indexed by the linear cell index. \sa CalcVolumeFractions
+	map<size_t, vector<pair<int,float> > > m_Fractions;
+
+	//! Get the position of a cell in the cell arrays, x is the fastest running index.
+	size_t GetLinearIndex(const unsigned int pos[3]) const {return pos[0] + m_NumCells[0]*(pos[1] + (size_t)m_NumCells[1]*pos[2]);}
+	//! Get the center coordinates of a cell.
+	void GetCellCenter(const unsigned int pos[3], double center[3]) const;
+	//! Classify all cells in the given range (stop is inclusive), requires InitCandidates.
+	void RasterizeRange(const unsigned int start[3], const unsigned int stop[3]);
+	//! Freeze the geometry and collect all primitives of interest from the structure. \sa m_Candidates
+	void InitCandidates();
+	//! Classify a block of cells (stop is inclusive), only the given candidates may be found inside this block.
+	void RasterizeBlock(const unsigned int start[3], const unsigned int stop[3], const vector<size_t> &candidates);
+	//! Fill all cells of a block with the given property table index.
+	void FillBlock(const unsigned int start[3], const unsigned int stop[3], int idx);
+	//! Get the index of the given property in the property table, append it if necessary.
+	int GetTableIndex(CSProperties* prop);
+
+	//! Get the property table index at the given coordinate.
+	int ClassifyPoint(const double coord[3]);
+	//! Get the volume of the given box (in mesh coordinates).
+	double GetVolume(const double lo[3], const double hi[3]) const;
+	//! Exact volume fractions of a cell if only axis-aligned boxes of the given candidates are involved. \return false if not applicable.
+	bool CalcBoxFractions(const double lo[3], const double hi[3], map<int,double> &volumes, const vector<size_t> &candidates);
+	//! Get all candidates that may overlap a plane of cells in the given z-range, including all candidates without a bounding box. \sa IsCellMixed
+	void GetMixedCandidates(double z_lo, double z_hi, vector<size_t> &candidates) const;
+	//! Check if the boundary of one of the given candidates may cross the cell, using its bounding box and signed distance.
+	bool IsCellMixed(const double lo[3], const double hi[3], const vector<size_t> &candidates) const;
+	//! Adaptive sampling of the volume fractions of a box, a box is bisected if it is not uniform or one of the candidates may cross it. \sa IsCellMixed
+	void SampleFractions(const double lo[3], const double hi[3], unsigned int level, map<int,double> &volumes, const vector<size_t> &candidates);
+};
+
+#endif // CSRASTERGRID_H
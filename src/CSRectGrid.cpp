@@ -22,11 +22,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <math.h>
 
 CSRectGrid::CSRectGrid(void)
 {
 	dDeltaUnit=1;
 	m_meshType = CARTESIAN;
+	for (int n=0;n<3;++n)
+		m_Unsorted[n]=false;
 }
 
 CSRectGrid::~CSRectGrid(void)
@@ -38,7 +41,10 @@ CSRectGrid* CSRectGrid::Clone(CSRectGrid* original)
 	CSRectGrid* clone = new CSRectGrid();
 	clone->dDeltaUnit = original->dDeltaUnit;
 	for (int i=0;i<3;++i)
+	{
 		clone->Lines[i] = original->Lines[i];
+		clone->m_Unsorted[i] = original->m_Unsorted[i];
+	}
 	for (int i=0;i<6;++i)
 		clone->SimBox[i] = original->SimBox[i];
 	return clone;
@@ -46,7 +52,10 @@ CSRectGrid* CSRectGrid::Clone(CSRectGrid* original)
 
 void CSRectGrid::AddDiscLine(int direct, double val)
 {
-	if ((direct>=0)&&(direct<3)) Lines[direct].push_back(val);
+	if ((direct<0)||(direct>=3)) return;
+	if ((m_Unsorted[direct]==false) && (Lines[direct].size()>0) && (Lines[direct].back()>=val))
+		m_Unsorted[direct]=true;
+	Lines[direct].push_back(val);
 }
 
 void CSRectGrid::AddDiscLines(int direct, int numLines, double* vals)
@@ -57,6 +66,64 @@ void CSRectGrid::AddDiscLines(int direct, int numLines, double* vals)
 	}
 }
 
+unsigned int CSRectGrid::MergeDiscLines(int direct, const vector<double> &vals, double tol)
+{
+	if (vals.size()==0) return 0;
+	return MergeDiscLines(direct, (int)vals.size(), &vals[0], tol);
+}
+
+unsigned int CSRectGrid::MergeDiscLines(int direct, int numLines, const double* vals, double tol)
+{
+	if ((direct<0)||(direct>=3)) return 0;
+	if ((numLines<=0) || (vals==NULL)) return 0;
+	EnsureSorted(direct);
+
+	vector<double> newLines(vals,vals+numLines);
+	for (size_t n=1;n<newLines.size();++n)
+		if (newLines[n]<newLines[n-1])
+		{
+			sort(newLines.begin(),newLines.end());
+			break;
+		}
+
+	const vector<double> &oldLines = Lines[direct];
+	vector<double> merged;
+	merged.reserve(oldLines.size()+newLines.size());
+
+	unsigned int inserted=0;
+	bool lastIsOld=false;
+	size_t i=0,j=0;
+	while ((i<oldLines.size()) || (j<newLines.size()))
+	{
+		if ((j>=newLines.size()) || ((i<oldLines.size()) && (oldLines[i]<=newLines[j])))
+		{
+			// existing line, replaces a close-by new line inserted just before
+			if ((merged.size()>0) && (lastIsOld==false) && (oldLines[i]-merged.back()<=tol))
+			{
+				merged.back()=oldLines[i++];
+				--inserted;
+			}
+			else
+				merged.push_back(oldLines[i++]);
+			lastIsOld=true;
+		}
+		else
+		{
+			// new line, dropped if too close to the previous line
+			if ((merged.size()>0) && (newLines[j]-merged.back()<=tol))
+				++j;
+			else
+			{
+				merged.push_back(newLines[j++]);
+				lastIsOld=false;
+				++inserted;
+			}
+		}
+	}
+	Lines[direct].swap(merged);
+	return inserted;
+}
+
 string CSRectGrid::AddDiscLines(int direct, int numLines, double* vals, string DistFunction)
 {
 	if ((direct<0)||(direct>=3)) return string("Unknown grid direction!");
@@ -96,6 +163,7 @@ string CSRectGrid::AddDiscLines(int direct, int numLines, double* vals, string D
 bool CSRectGrid::RemoveDiscLine(int direct, int index)
 {
 	if ((direct<0) || (direct>=3)) return false;
+	EnsureSorted(direct);
 	if ((index>=(int)Lines[direct].size()) || (index<0)) return false;
 	vector<double>::iterator vIter=Lines[direct].begin();
 	Lines[direct].erase(vIter+index);
@@ -105,11 +173,12 @@ bool CSRectGrid::RemoveDiscLine(int direct, int index)
 bool CSRectGrid::RemoveDiscLine(int direct, double val)
 {
 	if ((direct<0) || (direct>=3)) return false;
-	for (size_t i=0;i<Lines[direct].size();++i)
-	{
-		if (Lines[direct].at(i)==val) return RemoveDiscLine(direct,(int)i);
-	}
-	return false;
+	EnsureSorted(direct);
+	vector<double>::iterator vIter = lower_bound(Lines[direct].begin(),Lines[direct].end(),val);
+	if ((vIter==Lines[direct].end()) || (*vIter!=val))
+		return false;
+	Lines[direct].erase(vIter);
+	return true;
 }
 
 void CSRectGrid::clear()
@@ -117,6 +186,8 @@ void CSRectGrid::clear()
 	Lines[0].clear();
 	Lines[1].clear();
 	Lines[2].clear();
+	for (int n=0;n<3;++n)
+		m_Unsorted[n]=false;
 	dDeltaUnit=1;
 }
 
@@ -124,19 +195,27 @@ void CSRectGrid::ClearLines(int direct)
 {
 	if ((direct<0) || (direct>=3)) return;
 	Lines[direct].clear();
+	m_Unsorted[direct]=false;
 }
 
 bool CSRectGrid::SetLine(int direct, size_t Index, double value)
 {
 	if ((direct<0) || (direct>=3)) return false;
+	EnsureSorted(direct);
 	if (Lines[direct].size()<=Index) return false;
 	Lines[direct].at(Index) = value;
+	// only mark as unsorted if the new value breaks the order with its neighbours
+	if ((Index>0) && (Lines[direct].at(Index-1)>=value))
+		m_Unsorted[direct]=true;
+	if ((Index+1<Lines[direct].size()) && (Lines[direct].at(Index+1)<=value))
+		m_Unsorted[direct]=true;
 	return true;
 }
 
 double CSRectGrid::GetLine(int direct, size_t Index)
 {
 	if ((direct<0) || (direct>=3)) return 0;
+	EnsureSorted(direct);
 	if (Lines[direct].size()<=Index) return 0;
 	return Lines[direct].at(Index);
 }
@@ -144,7 +223,8 @@ double CSRectGrid::GetLine(int direct, size_t Index)
 double* CSRectGrid::GetLines(int direct, double *array, unsigned int &qty, bool sorted)
 {
 	if ((direct<0) || (direct>=3)) return 0;
-	if (sorted) Sort(direct);
+	UNUSED(sorted); // lines are always kept in increasing order
+	EnsureSorted(direct);
 	delete[] array;
 	array = new double[Lines[direct].size()];
 	for (size_t i=0;i<Lines[direct].size();++i) array[i]=Lines[direct].at(i);
@@ -156,6 +236,7 @@ string CSRectGrid::GetLinesAsString(int direct)
 {
 	stringstream xStr;
 	if ((direct<0)||(direct>=3)) return xStr.str();
+	EnsureSorted(direct);
 	if (Lines[direct].size()>0)
 	{
 		for (size_t i=0;i<Lines[direct].size();++i)
@@ -172,6 +253,7 @@ unsigned int CSRectGrid::Snap2LineNumber(int ny, double value, bool &inside) con
 	inside = false;
 	if ((ny<0) || (ny>2))
 		return -1;
+	EnsureSorted(ny);
 	if (Lines[ny].size()==0)
 		return -1;
 	if (value<Lines[ny].at(0))
@@ -189,6 +271,8 @@ unsigned int CSRectGrid::Snap2LineNumber(int ny, double value, bool &inside) con
 
 int CSRectGrid::GetDimension()
 {
+	for (int n=0;n<3;++n)
+		EnsureSorted(n);
 	if (Lines[0].size()==0) return -1;
 	if (Lines[1].size()==0) return -1;
 	if (Lines[2].size()==0) return -1;
@@ -202,38 +286,51 @@ int CSRectGrid::GetDimension()
 void CSRectGrid::IncreaseResolution(int nu, int factor)
 {
 	if ((nu<0) || (nu>=GetDimension())) return;
-	if ((factor<=1) && (factor>9)) return;
+	if ((factor<2) || (factor>9)) return;
 	size_t size=Lines[nu].size();
+	if (size<2) return;
+	// the new lines are created in increasing order and can be merged in a single pass
+	vector<double> newLines;
+	newLines.reserve((size-1)*(factor-1));
 	for (size_t i=0;i<size-1;++i)
 	{
 		double delta=(Lines[nu].at(i+1)-Lines[nu].at(i))/factor;
 		for (int n=1;n<factor;++n)
 		{
-			AddDiscLine(nu,Lines[nu].at(i)+n*delta);
+			newLines.push_back(Lines[nu].at(i)+n*delta);
 		}
 	}
-	Sort(nu);
+	MergeDiscLines(nu,newLines);
 }
 
 
 void CSRectGrid::Sort(int direct)
 {
 	if ((direct<0) || (direct>=3)) return;
+	if (m_Unsorted[direct]==false) return;
 	vector<double>::iterator start = Lines[direct].begin();
 	vector<double>::iterator end = Lines[direct].end();
 	sort(start,end);
 	end=unique(start,end);
 	Lines[direct].erase(end,Lines[direct].end());
+	m_Unsorted[direct]=false;
+}
+
+void CSRectGrid::EnsureSorted(int direct) const
+{
+	if (m_Unsorted[direct])
+		const_cast<CSRectGrid*>(this)->Sort(direct);
 }
 
 double* CSRectGrid::GetSimArea()
 {
 	for (int i=0;i<3;++i)
 	{
+		EnsureSorted(i);
 		if (Lines[i].size()!=0)
 		{
-			SimBox[2*i]=*min_element(Lines[i].begin(),Lines[i].end());
-			SimBox[2*i+1]=*max_element(Lines[i].begin(),Lines[i].end());
+			SimBox[2*i]=Lines[i].front();
+			SimBox[2*i+1]=Lines[i].back();
 		}
 		else SimBox[2*i]=SimBox[2*i+1]=0;
 	}
@@ -248,10 +345,115 @@ bool CSRectGrid::isValid()
 	return true;
 }
 
+bool CSRectGrid::AnalyseMesh(MeshQuality &quality)
+{
+	quality.timestep=0;
+	for (int n=0;n<3;++n)
+	{
+		EnsureSorted(n);
+		const vector<double> &lines = Lines[n];
+		quality.numLines[n]=lines.size();
+		quality.minRes[n]=quality.maxRes[n]=0;
+		quality.maxRatio[n]=1;
+		quality.maxRatioPos[n]=0;
+		if (lines.size()<2)
+			continue;
+		double delta_prev = lines[1]-lines[0];
+		quality.minRes[n]=quality.maxRes[n]=delta_prev;
+		for (size_t i=2;i<lines.size();++i)
+		{
+			double delta = lines[i]-lines[i-1];
+			if (delta<quality.minRes[n])
+				quality.minRes[n]=delta;
+			if (delta>quality.maxRes[n])
+				quality.maxRes[n]=delta;
+			double ratio = max(delta/delta_prev,delta_prev/delta);
+			if (ratio>quality.maxRatio[n])
+			{
+				quality.maxRatio[n]=ratio;
+				quality.maxRatioPos[n]=i-1;
+			}
+			delta_prev = delta;
+		}
+	}
+	if (isValid()==false)
+		return false;
+
+	double minWidth[3];
+	for (int n=0;n<3;++n)
+		minWidth[n] = quality.minRes[n]*dDeltaUnit;
+	if (m_meshType==CYLINDRICAL)
+	{
+		// the smallest alpha-width is found at the smallest (non-zero) radius
+		vector<double>::const_iterator rho = upper_bound(Lines[0].begin(),Lines[0].end(),0.0);
+		if (rho==Lines[0].end())
+			return true;
+		minWidth[1] = quality.minRes[1]*(*rho)*dDeltaUnit;
+	}
+	double inv_sum=0;
+	for (int n=0;n<3;++n)
+	{
+		if (minWidth[n]<=0)
+			return true;
+		inv_sum += 1.0/(minWidth[n]*minWidth[n]);
+	}
+	quality.timestep = 1.0/(CSXCAD_C0*sqrt(inv_sum));
+	return true;
+}
+
+unsigned int CSRectGrid::CheckMesh(int direct, double min_res, double max_res, double ratio, vector<unsigned int>* pos)
+{
+	if ((direct<0) || (direct>=3)) return 0;
+	EnsureSorted(direct);
+	const vector<double> &lines = Lines[direct];
+	unsigned int EC=0;
+	for (size_t i=1;i<lines.size();++i)
+	{
+		double delta = lines[i]-lines[i-1];
+		if ((delta>max_res) || (delta<min_res))
+		{
+			++EC;
+			if (pos) pos->push_back(i-1);
+		}
+		if (i<2)
+			continue;
+		// allow a small tolerance, as in CheckMesh.m
+		double grading = delta/(lines[i-1]-lines[i-2]);
+		if ((grading>ratio*1.01) || (grading<1.0/ratio/1.01))
+		{
+			++EC;
+			if (pos) pos->push_back(i-1);
+		}
+	}
+	return EC;
+}
+
+double CSRectGrid::GetMaxCellWidth(int direct, double start, double stop)
+{
+	if ((direct<0) || (direct>=3)) return 0;
+	EnsureSorted(direct);
+	const vector<double> &lines = Lines[direct];
+	if (lines.size()<2)
+		return 0;
+	if (start>stop)
+		swap(start,stop);
+	// first cell ending above start, last cell starting below stop
+	size_t first = upper_bound(lines.begin(),lines.end(),start)-lines.begin();
+	size_t last = lower_bound(lines.begin(),lines.end(),stop)-lines.begin();
+	if (first<1) first=1;
+	if (last>lines.size()-1) last=lines.size()-1;
+	double max_width=0;
+	for (size_t i=first;i<=last;++i)
+		max_width = max(max_width,lines[i]-lines[i-1]);
+	return max_width;
+}
+
 
 bool CSRectGrid::Write2XML(TiXmlNode &root, bool sorted)
 {
-	if (sorted) {Sort(0);Sort(1);Sort(2);}
+	UNUSED(sorted); // lines are always written in increasing order
+	for (int n=0;n<3;++n)
+		EnsureSorted(n);
 	TiXmlElement grid("RectilinearGrid");
 
 	grid.SetDoubleAttribute("DeltaUnit",dDeltaUnit);
@@ -329,12 +531,7 @@ bool CSRectGrid::ReadFromXML(TiXmlNode &root)
 	}
 
 	for (int i=0;i<3;++i)
-	{
-		vector<double> lines = SplitString2Double(LineStr[i],',');
-		for (size_t n=0;n<lines.size();++n)
-			AddDiscLine(i,lines.at(n));
-		Sort(i);
-	}
+		MergeDiscLines(i,SplitString2Double(LineStr[i],','));
 
 	return true;
 }
@@ -50,6 +50,18 @@ public:
 	void AddDiscLines(int direct, int numLines, double* vals);
 	string AddDiscLines(int direct, int numLines, double* vals, string DistFunction);
 
+	//! Merge a run of disc-lines into the (sorted) lines of the given direction.
+	/*!
+	 The new lines are merged in linear time, lines closer than \a tol to an already existing line are dropped. Existing lines are never moved or removed.
+	 \param direct The direction of interest.
+	 \param numLines Number of new lines.
+	 \param vals The new lines, preferably in increasing order (will be sorted otherwise).
+	 \param tol Tolerance to detect duplicate lines.
+	 \return Number of lines actually inserted.
+	 */
+	unsigned int MergeDiscLines(int direct, int numLines, const double* vals, double tol=0);
+	unsigned int MergeDiscLines(int direct, const vector<double> &vals, double tol=0);
+
 	//! Remove the disc-line at certain index and direction.
 	bool RemoveDiscLine(int direct, int index);
 	//! Remove the disc-line at certain value and direction.
@@ -73,11 +85,11 @@ public:
 	\param direct The direction of interest.
 	\param array The array in which the lines will be stored. Can be NULL. Caller has to delete the array.
 	\param qty Methode will return the number of lines in this direction.
-	\param sorted Define here whether the lines shall be in increasing order (default) or as currently stored (unknown order).
+	\param sorted Obsolete, the lines are always returned in increasing order.
 	 */
 	double* GetLines(int direct, double *array, unsigned int &qty, bool sorted=true);
 	//! Get quantity of lines in certain direction.
-	size_t GetQtyLines(int direct) {if ((direct>=0) && (direct<3)) return Lines[direct].size(); else return 0;}
+	size_t GetQtyLines(int direct) {if ((direct>=0) && (direct<3)) {EnsureSorted(direct); return Lines[direct].size();} else return 0;}
 	//! Get a disc-line in a certain direction an at given index.
 	double GetLine(int direct, size_t Index);
 	//! Get disc-lines as a comma-seperated string for given direction
@@ -103,17 +115,53 @@ public:
 	//! Increase the resolution in the specified direction by the given factor.
 	void IncreaseResolution(int nu, int factor);
 
-	//! Sort the lines in a given direction.
+	//! Sort the lines in a given direction and remove duplicates. Nothing to do if no lines were added since the last sort.
 	void Sort(int direct);
 
+	//! Check whether the lines in a given direction are currently sorted.
+	bool IsSorted(int direct) const {if ((direct>=0) && (direct<3)) return !m_Unsorted[direct]; else return false;}
+
 	//! Get the bounding box of the area defined by the disc-lines.
 	double* GetSimArea();
 
 	//! This will check if the given mesh is a valid 3D mesh (at least 2 lines in all directions);
 	bool isValid();
 
+	//! Mesh quality information. \sa AnalyseMesh
+	struct MeshQuality
+	{
+		unsigned int numLines[3];		//!< number of lines in each direction
+		double minRes[3];				//!< smallest cell width in each direction (in drawing units or radian)
+		double maxRes[3];				//!< largest cell width in each direction (in drawing units or radian)
+		double maxRatio[3];				//!< max. grading ratio of two neighboring cells in each direction
+		unsigned int maxRatioPos[3];	//!< index of the line between the two cells with the max. grading ratio
+		double timestep;				//!< estimated FDTD timestep (Courant criterion) in seconds
+	};
+
+	//! Analyse the mesh in all directions in a single pass (native version of AnalyseMesh.m). \return false if the mesh is not a valid 3D mesh.
+	bool AnalyseMesh(MeshQuality &quality);
+
+	//! Check the mesh lines in the given direction (native version of CheckMesh.m).
+	/*!
+	 \param direct The direction of interest.
+	 \param min_res Minimal allowed cell width.
+	 \param max_res Maximal allowed cell width.
+	 \param ratio Maximal allowed grading ratio of two neighboring cells.
+	 \param pos Optional, the line indices with errors will be added to this vector.
+	 \return Number of errors found.
+	 */
+	unsigned int CheckMesh(int direct, double min_res, double max_res, double ratio, vector<unsigned int>* pos=NULL);
+
+	//! Get the largest cell width in the given direction for all cells overlapping the interval [start,stop]. \return 0 if no cell overlaps.
+	double GetMaxCellWidth(int direct, double start, double stop);
+
 protected:
-	vector<double> Lines[3];
+	//! Make sure the lines in the given direction are sorted before reading them. \sa Sort
+	void EnsureSorted(int direct) const;
+
+	mutable vector<double> Lines[3];
+	//! Flag lines added or changed since the last sort
+	mutable bool m_Unsorted[3];
 	double dDeltaUnit;
 	double SimBox[6];
 	CoordinateSystem m_meshType;
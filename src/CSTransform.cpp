@@ -22,8 +22,10 @@
 
 #include <math.h>
 #include <iostream>
-
-#include "vtkMatrix4x4.h"
+#include <new>
+#if defined(WIN32)
+#include <malloc.h>
+#endif
 
 #define PI 3.141592653589793238462643383279
 
@@ -63,6 +65,39 @@ CSTransform::~CSTransform()
 {
 }
 
+void* CSTransform::operator new(size_t size)
+{
+	void* ptr = NULL;
+#if defined(WIN32)
+	ptr = _aligned_malloc(size, 64);
+#else
+	if (posix_memalign(&ptr, 64, size)!=0)
+		ptr = NULL;
+#endif
+	if (ptr==NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void CSTransform::operator delete(void* ptr)
+{
+#if defined(WIN32)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+void* CSTransform::operator new[](size_t size)
+{
+	return CSTransform::operator new(size);
+}
+
+void CSTransform::operator delete[](void* ptr)
+{
+	CSTransform::operator delete(ptr);
+}
+
 void CSTransform::Reset()
 {
 	m_PostMultiply = true;
@@ -89,8 +124,112 @@ void CSTransform::Invert()
 
 void CSTransform::UpdateInverse()
 {
-	// use vtk to do the matrix inversion
-	vtkMatrix4x4::Invert(m_TMatrix, m_Inv_TMatrix);
+	if (InvertMatrix(m_TMatrix, m_Inv_TMatrix)==false)
+		cerr << __func__ << ": Error, transformation matrix is singular, inverse matrix not updated" << endl;
+}
+
+bool CSTransform::IsAffineMatrix(const double matrix[16])
+{
+	return (matrix[12]==0) && (matrix[13]==0) && (matrix[14]==0) && (matrix[15]==1);
+}
+
+bool CSTransform::InvertMatrix(const double matrix[16], double inverse[16])
+{
+	double inv[16];
+	if (IsAffineMatrix(matrix))
+	{
+		// inverse of the 3x3 part by its cofactors, the translation is rotated back: t' = -R^-1 * t
+		const double* m = matrix;
+		double c00 = m[5]*m[10]-m[6]*m[9];
+		double c01 = m[6]*m[8]-m[4]*m[10];
+		double c02 = m[4]*m[9]-m[5]*m[8];
+		double det = m[0]*c00+m[1]*c01+m[2]*c02;
+		if (det==0)
+			return false;
+		double inv_det = 1.0/det;
+		inv[0]  = c00*inv_det;
+		inv[1]  = (m[2]*m[9]-m[1]*m[10])*inv_det;
+		inv[2]  = (m[1]*m[6]-m[2]*m[5])*inv_det;
+		inv[4]  = c01*inv_det;
+		inv[5]  = (m[0]*m[10]-m[2]*m[8])*inv_det;
+		inv[6]  = (m[2]*m[4]-m[0]*m[6])*inv_det;
+		inv[8]  = c02*inv_det;
+		inv[9]  = (m[1]*m[8]-m[0]*m[9])*inv_det;
+		inv[10] = (m[0]*m[5]-m[1]*m[4])*inv_det;
+		for (int r=0;r<3;++r)
+			inv[4*r+3] = -(inv[4*r]*m[3]+inv[4*r+1]*m[7]+inv[4*r+2]*m[11]);
+		inv[12] = inv[13] = inv[14] = 0;
+		inv[15] = 1;
+	}
+	else
+	{
+		// general (projective) matrix, Gauss-Jordan elimination with partial pivoting
+		double a[16];
+		for (int n=0;n<16;++n)
+			a[n] = matrix[n];
+		for (int n=0;n<16;++n)
+			inv[n] = (n%5==0) ? 1 : 0;
+		for (int c=0;c<4;++c)
+		{
+			int pivot = c;
+			for (int r=c+1;r<4;++r)
+				if (fabs(a[4*r+c])>fabs(a[4*pivot+c]))
+					pivot = r;
+			if (a[4*pivot+c]==0)
+				return false;
+			if (pivot!=c)
+				for (int n=0;n<4;++n)
+				{
+					swap(a[4*c+n],a[4*pivot+n]);
+					swap(inv[4*c+n],inv[4*pivot+n]);
+				}
+			double scale = 1.0/a[4*c+c];
+			for (int n=0;n<4;++n)
+			{
+				a[4*c+n] *= scale;
+				inv[4*c+n] *= scale;
+			}
+			for (int r=0;r<4;++r)
+			{
+				if ((r==c) || (a[4*r+c]==0))
+					continue;
+				double f = a[4*r+c];
+				for (int n=0;n<4;++n)
+				{
+					a[4*r+n] -= f*a[4*c+n];
+					inv[4*r+n] -= f*inv[4*c+n];
+				}
+			}
+		}
+	}
+	for (int n=0;n<16;++n)
+		inverse[n] = inv[n];
+	return true;
+}
+
+void CSTransform::MatrixTransformBatch(const double matrix[16], size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z)
+{
+	const double m0=matrix[0], m1=matrix[1], m2=matrix[2], m3=matrix[3];
+	const double m4=matrix[4], m5=matrix[5], m6=matrix[6], m7=matrix[7];
+	const double m8=matrix[8], m9=matrix[9], m10=matrix[10], m11=matrix[11];
+	for (size_t i=0;i<num;++i)
+	{
+		// read all input values first, the output arrays may be the input arrays
+		double px=x[i], py=y[i], pz=z[i];
+		out_x[i] = m0*px+m1*py+m2*pz+m3;
+		out_y[i] = m4*px+m5*py+m6*pz+m7;
+		out_z[i] = m8*px+m9*py+m10*pz+m11;
+	}
+}
+
+void CSTransform::TransformBatch(size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z) const
+{
+	MatrixTransformBatch(m_TMatrix,num,x,y,z,out_x,out_y,out_z);
+}
+
+void CSTransform::InvertTransformBatch(size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z) const
+{
+	MatrixTransformBatch(m_Inv_TMatrix,num,x,y,z,out_x,out_y,out_z);
 }
 
 double* CSTransform::Transform(const double inCoords[3], double outCoords[3]) const
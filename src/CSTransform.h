@@ -37,6 +37,12 @@ public:
 	CSTransform(ParameterSet* paraSet);
 	virtual ~CSTransform();
 
+	//! Transformations are allocated aligned to a cache line, the default operator new does not guarantee the alignment of the matrices.
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+	static void* operator new[](size_t size);
+	static void operator delete[](void* ptr);
+
 	void SetParameterSet(ParameterSet* paraset) {m_ParaSet=paraset;}
 
 	enum TransformType
@@ -47,9 +53,23 @@ public:
 	double* Transform(const double inCoords[3], double outCoords[3]) const;
 	double* InvertTransform(const double inCoords[3], double outCoords[3]) const;
 
+	//! Transform a number of coordinates at once, given as separate x, y and z arrays. The output arrays may be the input arrays.
+	void TransformBatch(size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z) const;
+	//! Inverse transform a number of coordinates at once, given as separate x, y and z arrays. The output arrays may be the input arrays.
+	void InvertTransformBatch(size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z) const;
+
 	void Invert();
 
 	double* GetMatrix() {return m_TMatrix;}
+	//! Get the (precomputed) inverse transform matrix.
+	const double* GetInverseMatrix() const {return m_Inv_TMatrix;}
+
+	//! Check if the given matrix is affine, i.e. its last row is (0,0,0,1).
+	static bool IsAffineMatrix(const double matrix[16]);
+	//! Invert a 4x4 matrix, an affine matrix is inverted using only its 3x3 part and translation. \return false if the matrix is singular, the inverse is not changed.
+	static bool InvertMatrix(const double matrix[16], double inverse[16]);
+	//! Apply the affine part of a 4x4 matrix to a number of coordinates. \sa TransformBatch
+	static void MatrixTransformBatch(const double matrix[16], size_t num, const double* x, const double* y, const double* z, double* out_x, double* out_y, double* out_z);
 
 	//! Apply a matrix directly
 	void SetMatrix(const double matrix[16], bool concatenate=true);
@@ -114,10 +134,10 @@ public:
 	static CSTransform* New(CSTransform* cst, ParameterSet* paraSet=NULL);
 
 protected:
-	//transform matrix
-	double m_TMatrix[16];
-	//inverse transform matrix
-	double m_Inv_TMatrix[16];
+	//transform matrix, aligned to a cache line
+	CSXCAD_ALIGN(64) double m_TMatrix[16];
+	//inverse transform matrix, aligned to a cache line
+	CSXCAD_ALIGN(64) double m_Inv_TMatrix[16];
 
 	void UpdateInverse();
 
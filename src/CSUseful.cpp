@@ -18,6 +18,7 @@
 #include "CSUseful.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <locale.h>
 #include <sstream>
 #include <iostream>
 
@@ -46,23 +47,83 @@ double String2Double(string number, int accurarcy)
 }
 
 
-std::vector<double> SplitString2Double(std::string str, const char delimiter)
+//! The fast conversion functions of the C library can only be used if they use a '.' as decimal point.
+static bool UseCNumeric()
+{
+	const char* dp = localeconv()->decimal_point;
+	return (dp!=NULL) && (dp[0]=='.') && (dp[1]==0);
+}
+
+//! Convert the value in the range [str,end), returns 0 for an empty or invalid value.
+static double Token2Double(const char* str, const char* end, bool c_numeric)
+{
+	if (str==end)
+		return 0;
+	if (c_numeric)
+	{
+		char* val_end;
+		double val = strtod(str,&val_end);
+		if (val_end<=end)
+			return val;
+	}
+	return String2Double(string(str,end));
+}
+
+static int Token2Int(const char* str, const char* end, bool c_numeric)
+{
+	if (str==end)
+		return 0;
+	if (c_numeric)
+	{
+		char* val_end;
+		long val = strtol(str,&val_end,10);
+		if (val_end<=end)
+			return (int)val;
+	}
+	return String2Int(string(str,end));
+}
+
+//! Get the end of the value starting at str, i.e. the next delimiter or the end of the string.
+static const char* TokenEnd(const char* str, const char delimiter)
+{
+	while ((*str!=0) && (*str!=delimiter))
+		++str;
+	return str;
+}
+
+std::vector<double> SplitString2Double(const std::string &str, const char delimiter)
 {
-	size_t pos=0;
-	std::string sub;
 	std::vector<double> values;
-	do
+	bool c_numeric = UseCNumeric();
+	const char* pos = str.c_str();
+	while (*pos!=0)
 	{
-		pos=str.find_first_of(delimiter);
-		if (pos==std::string::npos) pos=str.size();
-		else ++pos;
-		sub=str.substr(0,pos);
-		if (sub.empty()==false) values.push_back(String2Double(sub));
-		str.erase(0,pos);
-	} while (str.size()>0);
+		const char* end = TokenEnd(pos,delimiter);
+		values.push_back(Token2Double(pos,end,c_numeric));
+		if (*end==0)
+			break;
+		pos = end+1;
+	}
 	return values;
 }
 
+unsigned int SplitString2Double(const char* str, const char delimiter, double* values, unsigned int maxVal)
+{
+	bool c_numeric = UseCNumeric();
+	unsigned int num = 0;
+	while (*str!=0)
+	{
+		const char* end = TokenEnd(str,delimiter);
+		if (num<maxVal)
+			values[num] = Token2Double(str,end,c_numeric);
+		++num;
+		if (*end==0)
+			break;
+		str = end+1;
+	}
+	return num;
+}
+
 std::vector<string> SplitString2Vector(std::string str, const char delimiter)
 {
 	size_t pos=0;
@@ -88,71 +149,102 @@ std::vector<string> SplitString2Vector(std::string str, const char delimiter)
 }
 
 
-string CombineVector2String(vector<double> values, const char delimiter, int accurarcy)
+//! Append a value to str, using the fast conversion of the C library if possible.
+static void AppendValue(string &str, double value, int accurarcy, bool c_numeric)
 {
-	stringstream ss;
-	ss.precision( accurarcy );
-	for (size_t i=0;i<values.size();++i)
+	char buf[64];
+	if (c_numeric && (accurarcy<40))
 	{
-		if (i>0) ss << delimiter;
-		ss<<values.at(i);
+		int len = snprintf(buf, sizeof(buf), "%.*g", accurarcy, value);
+		if ((len>0) && (len<(int)sizeof(buf)))
+		{
+			str.append(buf,len);
+			return;
+		}
 	}
-	return ss.str();
+	stringstream ss;
+	ss.precision( accurarcy );
+	ss << value;
+	str.append(ss.str());
 }
 
-string CombineArray2String(double* values, unsigned int numVal, const char delimiter, int accurarcy)
+static void AppendValue(string &str, int value, int accurarcy, bool c_numeric)
 {
-	stringstream ss;
-	ss.precision( accurarcy );
-	for (unsigned int i=0;i<numVal;++i)
-	{
-		if (i>0) ss << delimiter;
-		ss<<values[i];
-	}
-	return ss.str();
+	UNUSED(accurarcy);
+	UNUSED(c_numeric);
+	char buf[16];
+	int len = snprintf(buf, sizeof(buf), "%d", value);
+	str.append(buf,len);
 }
 
-string CombineArray2String(float* values, unsigned int numVal, const char delimiter, int accurarcy)
+template <typename T> static string CombineValues(const T* values, unsigned int numVal, const char delimiter, int accurarcy)
 {
-	stringstream ss;
-	ss.precision( accurarcy );
+	bool c_numeric = UseCNumeric();
+	string str;
+	str.reserve(numVal*(accurarcy+8));
 	for (unsigned int i=0;i<numVal;++i)
 	{
-		if (i>0) ss << delimiter;
-		ss<<values[i];
+		if (i>0) str.push_back(delimiter);
+		AppendValue(str, values[i], accurarcy, c_numeric);
 	}
-	return ss.str();
+	return str;
 }
 
-string CombineArray2String(int* values, unsigned int numVal, const char delimiter, int accurarcy)
+string CombineVector2String(const vector<double> &values, const char delimiter, int accurarcy)
 {
-	stringstream ss;
-	ss.precision( accurarcy );
-	for (unsigned int i=0;i<numVal;++i)
-	{
-		if (i>0) ss << delimiter;
-		ss<<values[i];
-	}
-	return ss.str();
+	if (values.size()==0)
+		return string();
+	return CombineValues(&values[0], values.size(), delimiter, accurarcy);
 }
 
-std::vector<int> SplitString2Int(std::string str, const char delimiter)
+string CombineArray2String(const double* values, unsigned int numVal, const char delimiter, int accurarcy)
+{
+	return CombineValues(values, numVal, delimiter, accurarcy);
+}
+
+string CombineArray2String(const float* values, unsigned int numVal, const char delimiter, int accurarcy)
+{
+	return CombineValues(values, numVal, delimiter, accurarcy);
+}
+
+string CombineArray2String(const int* values, unsigned int numVal, const char delimiter, int accurarcy)
+{
+	return CombineValues(values, numVal, delimiter, accurarcy);
+}
+
+std::vector<int> SplitString2Int(const std::string &str, const char delimiter)
 {
-	size_t pos=0;
-	std::string sub;
 	std::vector<int> values;
-	do
+	bool c_numeric = UseCNumeric();
+	const char* pos = str.c_str();
+	while (*pos!=0)
 	{
-		pos=str.find_first_of(delimiter);
-		if (pos==std::string::npos) pos=str.size();
-		else ++pos;
-		sub=str.substr(0,pos);
-		if (sub.empty()==false) values.push_back(String2Int(sub));
-		str.erase(0,pos);
-	} while (str.size()>0);
+		const char* end = TokenEnd(pos,delimiter);
+		values.push_back(Token2Int(pos,end,c_numeric));
+		if (*end==0)
+			break;
+		pos = end+1;
+	}
 	return values;
 }
 
+unsigned int SplitString2Int(const char* str, const char delimiter, int* values, unsigned int maxVal)
+{
+	bool c_numeric = UseCNumeric();
+	unsigned int num = 0;
+	while (*str!=0)
+	{
+		const char* end = TokenEnd(str,delimiter);
+		if (num<maxVal)
+			values[num] = Token2Int(str,end,c_numeric);
+		++num;
+		if (*end==0)
+			break;
+		str = end+1;
+	}
+	return num;
+}
+
 CSDebug::CSDebug()
 {
 	m_level = 0;
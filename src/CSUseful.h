@@ -12,17 +12,28 @@ class CSDebug;
 
 using namespace std;
 
+//! Speed of light in vacuum (m/s).
+static const double CSXCAD_C0 = 299792458.0;
+
 string CSXCAD_EXPORT ConvertInt(int number);
 int CSXCAD_EXPORT String2Int(string number);
 double CSXCAD_EXPORT String2Double(string number, int accurarcy=15);
-vector<double> CSXCAD_EXPORT SplitString2Double(string str, const char delimiter);
+vector<double> CSXCAD_EXPORT SplitString2Double(const string &str, const char delimiter);
 vector<string> CSXCAD_EXPORT SplitString2Vector(string str, const char delimiter);
-string CSXCAD_EXPORT CombineVector2String(vector<double> values, const char delimiter, int accurarcy=15);
-string CSXCAD_EXPORT CombineArray2String(double* values, unsigned int numVal, const char delimiter, int accurarcy=15);
-string CSXCAD_EXPORT CombineArray2String(float* values, unsigned int numVal, const char delimiter, int accurarcy=15);
-string CSXCAD_EXPORT CombineArray2String(int* values, unsigned int numVal, const char delimiter, int accurarcy=15);
-
-vector<int> CSXCAD_EXPORT SplitString2Int(string str, const char delimiter);
+string CSXCAD_EXPORT CombineVector2String(const vector<double> &values, const char delimiter, int accurarcy=15);
+string CSXCAD_EXPORT CombineArray2String(const double* values, unsigned int numVal, const char delimiter, int accurarcy=15);
+string CSXCAD_EXPORT CombineArray2String(const float* values, unsigned int numVal, const char delimiter, int accurarcy=15);
+string CSXCAD_EXPORT CombineArray2String(const int* values, unsigned int numVal, const char delimiter, int accurarcy=15);
+
+vector<int> CSXCAD_EXPORT SplitString2Int(const string &str, const char delimiter);
+
+//! Parse the delimiter separated values of str into the given array, without any memory allocation.
+/*!
+ \return The number of values found in str, only the first maxVal values are stored.
+ */
+unsigned int CSXCAD_EXPORT SplitString2Double(const char* str, const char delimiter, double* values, unsigned int maxVal);
+//! Parse the delimiter separated values of str into the given array, without any memory allocation. \sa SplitString2Double
+unsigned int CSXCAD_EXPORT SplitString2Int(const char* str, const char delimiter, int* values, unsigned int maxVal);
 
 class CSXCAD_EXPORT CSDebug
 {
@@ -38,6 +38,20 @@
 // declare a parameter as unused
 #define UNUSED(x) (void)(x);
 
+// align a variable or member to the given number of bytes, e.g. to a cache line
+#if defined(_MSC_VER)
+#define CSXCAD_ALIGN(n) __declspec(align(n))
+#else
+#define CSXCAD_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+// declare a static variable with one instance per thread
+#if defined(_MSC_VER)
+#define CSXCAD_THREAD_LOCAL __declspec(thread)
+#else
+#define CSXCAD_THREAD_LOCAL __thread
+#endif
+
 enum CoordinateSystem
 {
 	CARTESIAN, CYLINDRICAL, UNDEFINED_CS
@@ -0,0 +1,260 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CSXMLStreamScanner.h"
+#include <string.h>
+#include <ctype.h>
+#include <limits>
+
+#define CSXML_STREAM_BUFFER_SIZE 65536
+
+CSXMLStreamScanner::CSXMLStreamScanner()
+{
+	m_File = NULL;
+	m_RangeFile = NULL;
+	m_BufPos = 0;
+	m_BufLen = 0;
+	m_Pos = 0;
+	m_RangePos = 0;
+	m_Depth = 0;
+}
+
+CSXMLStreamScanner::~CSXMLStreamScanner()
+{
+	Close();
+}
+
+bool CSXMLStreamScanner::Open(const char* file)
+{
+	Close();
+	m_File = gzopen(file, "rb");
+	if (m_File==NULL)
+		return false;
+	m_RangeFile = gzopen(file, "rb");
+	if (m_RangeFile==NULL)
+	{
+		Close();
+		return false;
+	}
+	m_Buffer.resize(CSXML_STREAM_BUFFER_SIZE);
+	return true;
+}
+
+void CSXMLStreamScanner::Close()
+{
+	if (m_File)
+		gzclose(m_File);
+	m_File = NULL;
+	if (m_RangeFile)
+		gzclose(m_RangeFile);
+	m_RangeFile = NULL;
+	m_BufPos = 0;
+	m_BufLen = 0;
+	m_Pos = 0;
+	m_RangePos = 0;
+	m_Depth = 0;
+}
+
+int CSXMLStreamScanner::Get()
+{
+	if (m_BufPos>=m_BufLen)
+	{
+		if (m_File==NULL)
+			return EOF;
+		int len = gzread(m_File, &m_Buffer[0], m_Buffer.size());
+		m_BufPos = 0;
+		m_BufLen = (len>0) ? len : 0;
+		if (m_BufLen==0)
+			return EOF;
+	}
+	++m_Pos;
+	return (unsigned char)m_Buffer[m_BufPos++];
+}
+
+bool CSXMLStreamScanner::SkipUntil(const char* str)
+{
+	// compare against a rolling window of the last characters read
+	size_t len = strlen(str);
+	string window;
+	int c;
+	while ((c=Get())!=EOF)
+	{
+		window.push_back((char)c);
+		if (window.size()>len)
+			window.erase(0,1);
+		if (window.compare(str)==0)
+			return true;
+	}
+	return false;
+}
+
+CSXMLStreamScanner::TokenType CSXMLStreamScanner::Next(string &name, streamoff &start, streamoff &end)
+{
+	name.clear();
+	int c;
+	while (true)
+	{
+		// skip text content
+		while (((c=Get())!=EOF) && (c!='<')) {}
+		if (c==EOF)
+			return END_OF_FILE;
+		start = m_Pos-1;
+
+		c = Get();
+		if (c=='?')
+		{
+			if (SkipUntil("?>")==false)
+				return TOKEN_ERROR;
+			continue;
+		}
+		if (c=='!')
+		{
+			c = Get();
+			if (c=='-')
+			{
+				if ((Get()!='-') || (SkipUntil("-->")==false))
+					return TOKEN_ERROR;
+			}
+			else if (c=='[')
+			{
+				if (SkipUntil("]]>")==false)
+					return TOKEN_ERROR;
+			}
+			else
+			{
+				// DOCTYPE or similar declaration, may contain an internal subset in brackets
+				int brackets = 0;
+				while ((c!=EOF) && ((c!='>') || (brackets>0)))
+				{
+					if (c=='[') ++brackets;
+					else if (c==']') --brackets;
+					c = Get();
+				}
+				if (c==EOF)
+					return TOKEN_ERROR;
+			}
+			continue;
+		}
+
+		bool end_tag = (c=='/');
+		if (end_tag)
+			c = Get();
+		while ((c!=EOF) && (isspace(c)==0) && (c!='/') && (c!='>'))
+		{
+			name.push_back((char)c);
+			c = Get();
+		}
+		if ((c==EOF) || name.empty())
+			return TOKEN_ERROR;
+
+		// skip the attributes, a '>' inside quotes does not end the tag
+		char quote = 0;
+		int last = 0;
+		while ((c!=EOF) && ((c!='>') || (quote!=0)))
+		{
+			if (quote)
+			{
+				if (c==quote)
+					quote = 0;
+			}
+			else if ((c=='"') || (c=='\''))
+				quote = (char)c;
+			if (isspace(c)==0)
+				last = c;
+			c = Get();
+		}
+		if (c==EOF)
+			return TOKEN_ERROR;
+		end = m_Pos;
+
+		if (end_tag)
+		{
+			--m_Depth;
+			return END_TAG;
+		}
+		if (last=='/')
+			return EMPTY_TAG;
+		++m_Depth;
+		return START_TAG;
+	}
+}
+
+bool CSXMLStreamScanner::Seek(streamoff pos)
+{
+	if ((m_File==NULL) || (pos<0))
+		return false;
+	m_Depth = 0;
+	if ((pos>=m_Pos) && (pos-m_Pos<=(streamoff)(m_BufLen-m_BufPos)))
+	{
+		// still inside the read buffer
+		m_BufPos += (size_t)(pos-m_Pos);
+		m_Pos = pos;
+		return true;
+	}
+	m_BufPos = 0;
+	m_BufLen = 0;
+	// see GetRange for offsets beyond the range of z_off_t
+	z_off_t seek_pos = (z_off_t)min(pos,(streamoff)numeric_limits<z_off_t>::max());
+	gzclearerr(m_File);
+	if (gzseek(m_File, seek_pos, SEEK_SET)!=seek_pos)
+		return false;
+	m_Pos = seek_pos;
+	while (m_Pos<pos)
+	{
+		if (Get()==EOF)
+			return false;
+	}
+	return true;
+}
+
+bool CSXMLStreamScanner::GetRange(streamoff start, streamoff end, string &content)
+{
+	content.clear();
+	if ((m_RangeFile==NULL) || (end<start))
+		return false;
+	// ranges are mostly requested in increasing order, a forward seek in a compressed file is cheap
+	// gzseek takes a z_off_t, which is 32 bit on some platforms, larger offsets are reached by reading forward
+	streamoff max_seek = (streamoff)numeric_limits<z_off_t>::max();
+	if ((start<m_RangePos) || (start<=max_seek))
+	{
+		z_off_t pos = (z_off_t)min(start,max_seek);
+		if (gzseek(m_RangeFile, pos, SEEK_SET)!=pos)
+			return false;
+		m_RangePos = pos;
+	}
+	char skip[CSXML_STREAM_BUFFER_SIZE];
+	while (m_RangePos<start)
+	{
+		unsigned int len = (unsigned int)min((streamoff)sizeof(skip), start-m_RangePos);
+		if (gzread(m_RangeFile, skip, len)!=(int)len)
+		{
+			m_RangePos = numeric_limits<streamoff>::max(); // unknown position, seek again next time
+			return false;
+		}
+		m_RangePos += len;
+	}
+	content.resize(end-start);
+	if (content.size()==0)
+		return true;
+	if (gzread(m_RangeFile, &content[0], content.size())!=(int)content.size())
+	{
+		m_RangePos = numeric_limits<streamoff>::max(); // unknown position, seek again next time
+		return false;
+	}
+	m_RangePos = end;
+	return true;
+}
@@ -0,0 +1,87 @@
+/*
+*	Copyright (C) 2008-2012 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as published
+*	by the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSXMLSTREAMSCANNER_H
+#define CSXMLSTREAMSCANNER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <ios>
+#include <zlib.h>
+
+using namespace std;
+
+//! Minimal streaming scanner for xml files
+/*!
+ This scanner reads a xml file sequentially and reports the start and end tags together with their file offsets.
+ Text, comments, processing instructions, CDATA sections and DOCTYPE declarations are skipped.
+ The content of a complete element can be read using GetRange and parsed separately, e.g. with TinyXML.
+ Gzip compressed files are decompressed on the fly.
+ All file offsets are 64 bit (std::streamoff), files larger than 2GB are supported even if z_off_t (long) is 32 bit.
+ \sa ContinuousStructure::ReadFromXMLStream
+ */
+class CSXMLStreamScanner
+{
+public:
+	enum TokenType
+	{
+		START_TAG, EMPTY_TAG, END_TAG, END_OF_FILE, TOKEN_ERROR
+	};
+
+	CSXMLStreamScanner();
+	virtual ~CSXMLStreamScanner();
+
+	//! Open the given file for scanning. \return false if the file can't be opened.
+	bool Open(const char* file);
+	void Close();
+
+	//! Get the next tag.
+	/*!
+	 \param name The name of the found tag.
+	 \param start File offset of the opening '<' of the tag.
+	 \param end File offset after the closing '>' of the tag.
+	 */
+	TokenType Next(string &name, streamoff &start, streamoff &end);
+
+	//! Continue scanning at the given file offset, which must be the start of a tag. The depth is reset to 0.
+	bool Seek(streamoff pos);
+
+	//! Read the file content between the given offsets, e.g. a complete element.
+	bool GetRange(streamoff start, streamoff end, string &content);
+
+	//! Current depth of the element tree, the document level is 0.
+	int GetDepth() const {return m_Depth;}
+
+protected:
+	gzFile m_File;
+	gzFile m_RangeFile;
+	vector<char> m_Buffer;
+	size_t m_BufPos;
+	size_t m_BufLen;
+	streamoff m_Pos;
+	//! Current position in the file used by GetRange.
+	streamoff m_RangePos;
+	int m_Depth;
+
+	//! Get the next character or EOF.
+	int Get();
+	//! Skip everything until (and including) the given string. \return false if the end of file was reached.
+	bool SkipUntil(const char* str);
+};
+
+#endif // CSXMLSTREAMSCANNER_H
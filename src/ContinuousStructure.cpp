@@ -32,6 +32,8 @@
 #include "CSPrimCurve.h"
 #include "CSPrimWire.h"
 #include "CSPrimUserDefined.h"
+#include "CSPrimInstance.h"
+#include "CSPrimCSG.h"
 
 #include "CSPropUnknown.h"
 #include "CSPropMaterial.h"
@@ -47,12 +49,111 @@
 #include "CSPropDumpBox.h"
 #include "CSPropResBox.h"
 
+#include "CSXMLStreamScanner.h"
+#include "CSArena.h"
+
 #include "tinyxml.h"
+#include <math.h>
+#include <boost/thread.hpp>
+#include <hdf5.h>
+#include <hdf5_hl.h>
+#include <zlib.h>
+#include <sys/stat.h>
+#if defined(WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+//! Version of the binary HDF5 structure format, increase if the layout changes. \sa ContinuousStructure::Write2HDF5
+#define CSXCAD_HDF5_VERSION 1.0
+
+struct CSHDF5Reader
+{
+	hid_t file_id;
+};
+
+#define CSX_GZIP_CHUNK_SIZE 1048576
+
+//! Check the file name for a ".gz" extension, used to write compressed structure files.
+static bool HasGZipExtension(const char* file)
+{
+	size_t len = strlen(file);
+	return (len>3) && (strcmp(file+len-3,".gz")==0);
+}
+
+//! Check for the gzip magic bytes, compressed files are detected independent of their name.
+static bool IsGZipFile(const char* file)
+{
+	FILE* fp = fopen(file,"rb");
+	if (fp==NULL)
+		return false;
+	unsigned char magic[2] = {0,0};
+	size_t num = fread(magic,1,2,fp);
+	fclose(fp);
+	return (num==2) && (magic[0]==0x1f) && (magic[1]==0x8b);
+}
+
+//! Decompress the given file into content, line breaks are normalized to '\n' like TiXmlDocument::LoadFile does.
+static bool ReadGZipFile(const char* file, string &content)
+{
+	content.clear();
+	gzFile gz = gzopen(file,"rb");
+	if (gz==NULL)
+		return false;
+	vector<char> buf(CSX_GZIP_CHUNK_SIZE);
+	int len;
+	bool last_cr = false;
+	while ((len=gzread(gz,&buf[0],buf.size()))>0)
+	{
+		for (int n=0;n<len;++n)
+		{
+			char c = buf[n];
+			if (last_cr && (c=='\n'))
+			{
+				last_cr = false;
+				continue;
+			}
+			last_cr = (c=='\r');
+			content.push_back(last_cr ? '\n' : c);
+		}
+	}
+	gzclose(gz);
+	return (len==0);
+}
+
+//! 64bit FNV-1a hash of the file content, used as key for the structure cache.
+static bool HashFile(const char* file, uint64_t &hash)
+{
+	FILE* fp = fopen(file,"rb");
+	if (fp==NULL)
+		return false;
+	hash = 14695981039346656037ULL;
+	vector<unsigned char> buf(CSX_GZIP_CHUNK_SIZE);
+	size_t len;
+	while ((len=fread(&buf[0],1,buf.size(),fp))>0)
+		for (size_t n=0;n<len;++n)
+		{
+			hash ^= buf[n];
+			hash *= 1099511628211ULL;
+		}
+	fclose(fp);
+	return true;
+}
 
 /*********************ContinuousStructure********************************************************************/
 ContinuousStructure::ContinuousStructure(void)
 {
 	clParaSet = new ParameterSet();
+	m_IndexValid = false;
+	m_PrimTableValid = false;
+	m_Revision = 0;
+	m_HDF5_Reader = NULL;
+	m_NumThreads = 1;
+	m_Arena = new CSArena();
+	const char* cache_dir = getenv("CSXCAD_CACHE_DIR");
+	if (cache_dir)
+		m_CacheDir = cache_dir;
 	//init datastructures...
 	clear();
 }
@@ -62,6 +163,8 @@ ContinuousStructure::~ContinuousStructure(void)
 	clear();
 	delete clParaSet;
 	clParaSet=NULL;
+	m_Arena->Release();
+	m_Arena=NULL;
 }
 
 void ContinuousStructure::AddProperty(CSProperties* prop)
@@ -70,8 +173,13 @@ void ContinuousStructure::AddProperty(CSProperties* prop)
 	prop->SetCoordInputType(m_MeshType);
 	prop->Update(&ErrString);
 	vProperties.push_back(prop);
+	prop->SetStructure(this);
 	prop->SetUniqueID(UniqueIDCounter++);
 	this->UpdateIDs();
+	++m_Revision;
+	// the new property is the last one, its primitives are appended in property order
+	if (m_IndexValid)
+		AddToIndex(prop);
 }
 
 bool ContinuousStructure::ReplaceProperty(CSProperties* oldProp, CSProperties* newProp)
@@ -81,6 +189,9 @@ bool ContinuousStructure::ReplaceProperty(CSProperties* oldProp, CSProperties* n
 	{
 		if (*iter==oldProp)
 		{
+			// the indexes are rebuilt on demand, no need to update them for every moved primitive
+			m_IndexValid = false;
+			++m_Revision;
 			CSPrimitives* prim=oldProp->GetPrimitive(0);
 			while (prim!=NULL)
 			{
@@ -88,9 +199,12 @@ bool ContinuousStructure::ReplaceProperty(CSProperties* oldProp, CSProperties* n
 				prim->SetProperty(newProp);
 				prim=oldProp->GetPrimitive(0);
 			}
+			oldProp->SetStructure(NULL);
 			delete *iter;
 			*iter=newProp;
+			newProp->SetStructure(this);
 			newProp->SetUniqueID(UniqueIDCounter++);
+			this->UpdateIDs();
 			return true;
 		}
 	}
@@ -100,29 +214,30 @@ bool ContinuousStructure::ReplaceProperty(CSProperties* oldProp, CSProperties* n
 void ContinuousStructure::DeleteProperty(size_t index)
 {
 	if (index>=vProperties.size()) return;
+	if (m_IndexValid)
+		RemoveFromIndex(vProperties.at(index));
+	// the property is detached first, deleting its primitives does not touch the indexes again
+	vProperties.at(index)->SetStructure(NULL);
 	vector<CSProperties*>::iterator iter=vProperties.begin();
 	delete vProperties.at(index);
 	vProperties.erase(iter+index);
 	this->UpdateIDs();
+	++m_Revision;
 }
 
 void ContinuousStructure::DeleteProperty(CSProperties* prop)
 {
-	vector<CSProperties*>::iterator iter;
-	for (iter=vProperties.begin();iter<vProperties.end();++iter)
-	{
-		if (*iter==prop)
-		{
-			delete *iter;
-			vProperties.erase(iter);
-		}
-	}
-	this->UpdateIDs();
+	int index = GetIndex(prop);
+	if (index>=0)
+		DeleteProperty((size_t)index);
 }
 
 int ContinuousStructure::GetIndex(CSProperties* prop)
 {
 	if (prop==NULL) return -1;
+	// the property ID equals the index, see UpdateIDs
+	if ((prop->GetID()<vProperties.size()) && (vProperties.at(prop->GetID())==prop))
+		return (int)prop->GetID();
 	for (size_t i=0;i<vProperties.size();++i)
 		if (vProperties.at(i)==prop) return (int)i;
 	return -1;
@@ -154,37 +269,47 @@ size_t ContinuousStructure::GetQtyPrimitives()
 
 vector<CSPrimitives*> ContinuousStructure::GetAllPrimitives()
 {
-	vector<CSPrimitives*> vPrim;
-	vPrim.reserve(GetQtyPrimitives());
-	for (size_t i=0;i<vProperties.size();++i)
-	{
-		vector<CSPrimitives*> prop_prims = vProperties.at(i)->GetAllPrimitives();
-		vPrim.insert(vPrim.end(),prop_prims.begin(),prop_prims.end());
-	}
-	return vPrim;
+	return GetPrimitiveTable();
+}
+
+const vector<CSPrimitives*>& ContinuousStructure::GetPrimitiveTable()
+{
+	UpdatePrimTable();
+	return m_PrimTable;
+}
+
+const vector<CSPrimitives*>& ContinuousStructure::GetPrimitiveTable(CSPrimitives::PrimitiveType type)
+{
+	UpdatePrimTable();
+	map<int, vector<CSPrimitives*> >::iterator it = m_PrimTypeTable.find(type);
+	if (it!=m_PrimTypeTable.end())
+		return it->second;
+	vector<CSPrimitives*> &table = m_PrimTypeTable[type];
+	for (size_t i=0;i<m_PrimTable.size();++i)
+		if (m_PrimTable.at(i)->GetType()==type)
+			table.push_back(m_PrimTable.at(i));
+	return table;
 }
 
 
 CSProperties* ContinuousStructure::HasPrimitive(CSPrimitives* prim)
 {
-	for (size_t i=0;i<vProperties.size();++i)
-		if (vProperties.at(i)->HasPrimitive(prim))
-			return vProperties.at(i);
-	return NULL;
+	UpdateIndex();
+	map<CSPrimitives*, CSProperties*>::const_iterator it = m_PrimPropIndex.find(prim);
+	if (it==m_PrimPropIndex.end())
+		return NULL;
+	return it->second;
 }
 
 void ContinuousStructure::DeletePrimitive(CSPrimitives* prim)
 {
-	// no special handling is necessary, deleted primitive will release itself from its owning property
+	// no special handling is necessary, deleted primitive will release itself from its owning property, which updates the indexes
 	delete prim;
 }
 
 vector<CSPrimitives*> ContinuousStructure::GetPrimitivesByType(CSPrimitives::PrimitiveType type)
 {
-	UNUSED(type);
-	vector<CSPrimitives*> vPrim;
-	cerr << __func__ << ": Error, not yet implemented!" << endl;
-	return vPrim;
+	return GetPrimitiveTable(type);
 }
 
 bool ContinuousStructure::InsertEdges2Grid(int nu)
@@ -193,35 +318,38 @@ bool ContinuousStructure::InsertEdges2Grid(int nu)
 	if (nu>2) return false;
 	double box[6] = {0,0,0,0,0,0};
 	bool accBound=false;
-	vector<CSPrimitives*> vPrimitives=GetAllPrimitives();
+	const vector<CSPrimitives*> &vPrimitives=GetPrimitiveTable();
+	vector<double> edges;
+	edges.reserve(2*vPrimitives.size());
 	for (size_t i=0;i<vPrimitives.size();++i)
 	{
 		accBound = vPrimitives.at(i)->GetBoundBox(box);
 		if (accBound)
 		{
-			clGrid.AddDiscLine(nu,box[2*nu]);
-			clGrid.AddDiscLine(nu,box[2*nu+1]);
+			edges.push_back(box[2*nu]);
+			edges.push_back(box[2*nu+1]);
 		}
 	}
-	clGrid.Sort(nu);
+	clGrid.MergeDiscLines(nu,edges);
 	return true;
 }
 
 CSPrimitives* ContinuousStructure::GetPrimitiveByID(unsigned int ID)
 {
-	vector<CSPrimitives*> vPrimitives=GetAllPrimitives();
-	for (size_t i=0;i<vPrimitives.size();++i)
-		if (vPrimitives.at(i)->GetID()==ID)
-			return vPrimitives.at(i);
-	return NULL;
+	UpdateIndex();
+	multimap<unsigned int, CSPrimitives*>::const_iterator it = m_PrimIDIndex.find(ID);
+	if (it==m_PrimIDIndex.end())
+		return NULL;
+	return it->second;
 }
 
 vector<CSProperties*> ContinuousStructure::GetPropertiesByName(string name)
 {
+	UpdateIndex();
 	vector<CSProperties*> vProp;
-	for (size_t i=0;i<vProperties.size();++i)
-		if (name.compare(vProperties.at(i)->GetName())==0)
-			vProp.push_back(vProperties.at(i));
+	pair<multimap<string, CSProperties*>::const_iterator, multimap<string, CSProperties*>::const_iterator> range = m_PropNameIndex.equal_range(name);
+	for (multimap<string, CSProperties*>::const_iterator it=range.first;it!=range.second;++it)
+		vProp.push_back(it->second);
 	return vProp;
 }
 
@@ -314,7 +442,7 @@ bool ContinuousStructure::isGeometryValid()
 	if (clGrid.GetQtyLines(1)<=1) return false;
 	if (clGrid.GetQtyLines(2)<=0) return false;
 
-	vector<CSPrimitives*> vPrimitives=GetAllPrimitives();
+	const vector<CSPrimitives*> &vPrimitives=GetPrimitiveTable();
 	for (size_t i=0;i<vPrimitives.size();++i)
 	{
 		if (vPrimitives.at(i)->Update()==false)
@@ -334,11 +462,60 @@ bool ContinuousStructure::isGeometryValid()
 	return true;
 }
 
+vector<double> ContinuousStructure::GetCellsPerWavelength(double freq)
+{
+	vector<double> cpw(vProperties.size(),0);
+	if ((freq<=0) || (clGrid.isValid()==false))
+		return cpw;
+	double unit = clGrid.GetDeltaUnit();
+	CoordinateSystem mesh_type = clGrid.GetMeshType();
+	for (size_t p=0;p<vProperties.size();++p)
+	{
+		CSPropMaterial* mat = vProperties.at(p)->ToMaterial();
+		if (mat==NULL)
+			continue;
+		double eps=0,mue=0;
+		for (int ny=0;ny<3;++ny)
+		{
+			eps = max(eps,mat->GetEpsilon(ny));
+			mue = max(mue,mat->GetMue(ny));
+		}
+		if ((eps<=0) || (mue<=0))
+			continue;
+		double lambda = CSXCAD_C0/freq/sqrt(eps*mue);
+
+		double max_width=0;
+		for (size_t i=0;i<mat->GetQtyPrimitives();++i)
+		{
+			CSPrimitives* prim = mat->GetPrimitive(i);
+			double box[6];
+			bool valid = prim->GetBoundBox(box);
+			// fall back to the full mesh if the bounding box is unknown or in a different coordinate system
+			if ((valid==false) || (prim->GetBoundBoxCoordSystem()!=mesh_type))
+				for (int n=0;n<3;++n)
+				{
+					box[2*n] = clGrid.GetLine(n,0);
+					box[2*n+1] = clGrid.GetLine(n,clGrid.GetQtyLines(n)-1);
+				}
+			for (int n=0;n<3;++n)
+			{
+				double width = clGrid.GetMaxCellWidth(n,box[2*n],box[2*n+1]);
+				if ((mesh_type==CYLINDRICAL) && (n==1))
+					width *= max(fabs(box[0]),fabs(box[1]));
+				max_width = max(max_width,width);
+			}
+		}
+		if (max_width>0)
+			cpw.at(p) = lambda/(max_width*unit);
+	}
+	return cpw;
+}
+
 double* ContinuousStructure::GetObjectArea()
 {
 	CSPrimitives* prim=NULL;
 	bool AccBound;
-	vector<CSPrimitives*> vPrimitives=GetAllPrimitives();
+	const vector<CSPrimitives*> &vPrimitives=GetPrimitiveTable();
 	for (size_t i=0;i<vPrimitives.size();++i)
 	{
 		prim=vPrimitives.at(i);
@@ -367,7 +544,7 @@ const char* ContinuousStructure::Update()
 	for (size_t i=0;i<vProperties.size();++i)
 		vProperties.at(i)->Update(&ErrString);
 
-	vector<CSPrimitives*> vPrimitives=GetAllPrimitives();
+	const vector<CSPrimitives*> &vPrimitives=GetPrimitiveTable();
 	for (size_t i=0;i<vPrimitives.size();++i)
 		vPrimitives.at(i)->Update(&ErrString);
 
@@ -380,12 +557,26 @@ void ContinuousStructure::clear()
 	dDrawingTol=0;
 	maxID=0;
 	m_BG_Mat.Reset();
+	m_IndexValid = false;
+	m_PrimTableValid = false;
+	++m_Revision;
+	// release the arena first, the objects deleted below are only counted and all chunks are dropped at once with the last one
+	// objects still referenced elsewhere keep the chunks of the old arena alive, see CSArena::Release
+	m_Arena->Release();
+	m_Arena = new CSArena();
 	for (unsigned int n=0;n<vProperties.size();++n)
 	{
+		vProperties.at(n)->SetStructure(NULL);
 		delete vProperties.at(n);
 		vProperties.at(n)=NULL;
 	}
 	vProperties.clear();
+	m_PrimIDIndex.clear();
+	m_PropNameIndex.clear();
+	m_PrimPropIndex.clear();
+	m_PrimTable.clear();
+	m_PrimTypeTable.clear();
+	m_PendingTrees.clear();
 	SetCoordInputType(CARTESIAN);
 	if (clParaSet)
 		clParaSet->clear();
@@ -427,13 +618,36 @@ bool ContinuousStructure::Write2XML(const char* file, bool parameterised, bool s
 
 	if (Write2XML(&doc,parameterised,sparse)==false) return false;
 
-	doc.SaveFile();
-	return doc.SaveFile();
+	if (HasGZipExtension(file)==false)
+		return doc.SaveFile();
+
+	TiXmlPrinter printer;
+	doc.Accept(&printer);
+	gzFile gz = gzopen(file,"wb");
+	if (gz==NULL)
+	{
+		cerr << __func__ << ": Error, failed to create file: " << file << endl;
+		return false;
+	}
+	// compress in chunks, the buffer size of zlib's write functions is limited
+	const char* data = printer.CStr();
+	size_t size = printer.Size();
+	bool ok = true;
+	for (size_t pos=0;(pos<size) && ok;pos+=CSX_GZIP_CHUNK_SIZE)
+	{
+		unsigned int len = (unsigned int)min((size_t)CSX_GZIP_CHUNK_SIZE,size-pos);
+		ok = (gzwrite(gz,data+pos,len)==(int)len);
+	}
+	ok = (gzclose(gz)==Z_OK) && ok;
+	if (ok==false)
+		cerr << __func__ << ": Error, failed to write file: " << file << endl;
+	return ok;
 }
 
 const char* ContinuousStructure::ReadFromXML(TiXmlNode* rootNode)
 {
 	clear();
+	CSArena::Scope arena_scope(m_Arena);
 	TiXmlNode* root = rootNode->FirstChild("ContinuousStructure");
 	if (root==NULL) { ErrString.append("Error: No ContinuousStructure found!!!\n"); return ErrString.c_str();}
 
@@ -467,56 +681,89 @@ const char* ContinuousStructure::ReadFromXML(TiXmlNode* rootNode)
 	if (probs==NULL) { ErrString.append("Warning: Properties not found!!!\n"); return ErrString.c_str();}
 
 	TiXmlElement* PropNode = probs->FirstChildElement();
-	CSProperties* newProp=NULL;
 	while (PropNode!=NULL)
 	{
-		const char* cProp=PropNode->Value();
-		if (strcmp(cProp,"Unknown")==0) newProp = new CSPropUnknown(clParaSet);
-		else if (strcmp(cProp,"Material")==0) newProp = new CSPropMaterial(clParaSet);
-		else if (strcmp(cProp,"DiscMaterial")==0) newProp = new CSPropDiscMaterial(clParaSet);
-		else if (strcmp(cProp,"LorentzMaterial")==0) newProp = new CSPropLorentzMaterial(clParaSet);
-		else if (strcmp(cProp,"DebyeMaterial")==0) newProp = new CSPropDebyeMaterial(clParaSet);
-		else if (strcmp(cProp,"LumpedElement")==0) newProp = new CSPropLumpedElement(clParaSet);
-		else if (strcmp(cProp,"Metal")==0) newProp = new CSPropMetal(clParaSet);
-		else if (strcmp(cProp,"ConductingSheet")==0) newProp = new CSPropConductingSheet(clParaSet);
-		else if (strcmp(cProp,"Excitation")==0) newProp = new CSPropExcitation(clParaSet);
-		else if (strcmp(cProp,"ProbeBox")==0) newProp = new CSPropProbeBox(clParaSet);
-		else if (strcmp(cProp,"ChargeBox")==0) newProp = new CSPropProbeBox(clParaSet); //old version support
-		else if (strcmp(cProp,"ResBox")==0) newProp = new CSPropResBox(clParaSet);
-		else if (strcmp(cProp,"DumpBox")==0) newProp = new CSPropDumpBox(clParaSet);
-		else
+		ReadProperty(PropNode);
+		PropNode=PropNode->NextSiblingElement();
+	}
+	BuildPendingTrees();
+	return ErrString.c_str();
+}
+
+CSProperties* ContinuousStructure::ReadProperty(TiXmlElement* PropNode, bool primitives)
+{
+	CSProperties* newProp=NULL;
+	const char* cProp=PropNode->Value();
+	if (strcmp(cProp,"Unknown")==0) newProp = new CSPropUnknown(clParaSet);
+	else if (strcmp(cProp,"Material")==0) newProp = new CSPropMaterial(clParaSet);
+	else if (strcmp(cProp,"DiscMaterial")==0) newProp = new CSPropDiscMaterial(clParaSet);
+	else if (strcmp(cProp,"LorentzMaterial")==0) newProp = new CSPropLorentzMaterial(clParaSet);
+	else if (strcmp(cProp,"DebyeMaterial")==0) newProp = new CSPropDebyeMaterial(clParaSet);
+	else if (strcmp(cProp,"LumpedElement")==0) newProp = new CSPropLumpedElement(clParaSet);
+	else if (strcmp(cProp,"Metal")==0) newProp = new CSPropMetal(clParaSet);
+	else if (strcmp(cProp,"ConductingSheet")==0) newProp = new CSPropConductingSheet(clParaSet);
+	else if (strcmp(cProp,"Excitation")==0) newProp = new CSPropExcitation(clParaSet);
+	else if (strcmp(cProp,"ProbeBox")==0) newProp = new CSPropProbeBox(clParaSet);
+	else if (strcmp(cProp,"ChargeBox")==0) newProp = new CSPropProbeBox(clParaSet); //old version support
+	else if (strcmp(cProp,"ResBox")==0) newProp = new CSPropResBox(clParaSet);
+	else if (strcmp(cProp,"DumpBox")==0) newProp = new CSPropDumpBox(clParaSet);
+	else
+	{
+		cerr << "ContinuousStructure::ReadFromXML: Property with type: " << cProp << " is unknown... " << endl;
+		newProp=NULL;
+	}
+	if (newProp && newProp->ToDiscMaterial() && clGrid.isValid())
+		newProp->ToDiscMaterial()->SetSimulationArea(clGrid.GetSimArea(),clGrid.GetMeshType());
+	if (newProp)
+	{
+		if (newProp->ReadFromXML(*PropNode))
 		{
-			cerr << "ContinuousStructure::ReadFromXML: Property with type: " << cProp << " is unknown... " << endl;
-			newProp=NULL;
+			AddProperty(newProp);
+			if (primitives)
+				ReadPropertyPrimitives(PropNode,newProp);
 		}
-		if (newProp)
+		else
 		{
+			delete newProp;
+			newProp = new CSPropUnknown(clParaSet);
 			if (newProp->ReadFromXML(*PropNode))
 			{
 				AddProperty(newProp);
-				ReadPropertyPrimitives(PropNode,newProp);
+				if (primitives)
+					ReadPropertyPrimitives(PropNode,newProp);
+				ErrString.append("Warning: Unknown Property found!!!\n");
 			}
 			else
 			{
+				ErrString.append("Warning: invalid Property found!!!\n");
 				delete newProp;
-				newProp = new CSPropUnknown(clParaSet);
-				if (newProp->ReadFromXML(*PropNode))
-				{
-					AddProperty(newProp);
-					ReadPropertyPrimitives(PropNode,newProp);
-					ErrString.append("Warning: Unknown Property found!!!\n");
-				}
-				else
-				{
-					ErrString.append("Warning: invalid Property found!!!\n");
-					delete newProp;
-					newProp=NULL;
-				}
+				newProp=NULL;
 			}
 		}
-        PropNode=PropNode->NextSiblingElement();
 	}
-	return ErrString.c_str();
+	return newProp;
+}
+
+CSPrimitives* ContinuousStructure::CreatePrimitive(const char* type, ParameterSet* paraSet, CSProperties* prop)
+{
+	if (strcmp(type,"Box")==0) return new CSPrimBox(paraSet,prop);
+	else if (strcmp(type,"MultiBox")==0) return new CSPrimMultiBox(paraSet,prop);
+	else if (strcmp(type,"Sphere")==0) return new CSPrimSphere(paraSet,prop);
+	else if (strcmp(type,"SphericalShell")==0) return new CSPrimSphericalShell(paraSet,prop);
+	else if (strcmp(type,"Cylinder")==0) return new CSPrimCylinder(paraSet,prop);
+	else if (strcmp(type,"CylindricalShell")==0) return new CSPrimCylindricalShell(paraSet,prop);
+	else if (strcmp(type,"Polygon")==0) return new CSPrimPolygon(paraSet,prop);
+	else if (strcmp(type,"LinPoly")==0) return new CSPrimLinPoly(paraSet,prop);
+	else if (strcmp(type,"RotPoly")==0) return new CSPrimRotPoly(paraSet,prop);
+	else if (strcmp(type,"Polyhedron")==0) return new CSPrimPolyhedron(paraSet,prop);
+	else if (strcmp(type,"PolyhedronReader")==0) return new CSPrimPolyhedronReader(paraSet,prop);
+	else if (strcmp(type,"Curve")==0) return new CSPrimCurve(paraSet,prop);
+	else if (strcmp(type,"Wire")==0) return new CSPrimWire(paraSet,prop);
+	else if (strcmp(type,"UserDefined")==0) return new CSPrimUserDefined(paraSet,prop);
+	else if (strcmp(type,"Point")==0) return new CSPrimPoint(paraSet,prop);
+	else if (strcmp(type,"Instance")==0) return new CSPrimInstance(paraSet,prop);
+	else if (strcmp(type,"CSG")==0) return new CSPrimCSG(paraSet,prop);
+	return NULL;
 }
 
 bool ContinuousStructure::ReadPropertyPrimitives(TiXmlElement* PropNode, CSProperties* prop)
@@ -532,59 +779,779 @@ bool ContinuousStructure::ReadPropertyPrimitives(TiXmlElement* PropNode, CSPrope
 	}
 
 	TiXmlElement* PrimNode = prims->FirstChildElement();
-	CSPrimitives* newPrim=NULL;
 	while (PrimNode!=NULL)
 	{
-		const char* cPrim=PrimNode->Value();
-		if (strcmp(cPrim,"Box")==0) newPrim = new CSPrimBox(clParaSet,prop);
-		else if (strcmp(cPrim,"MultiBox")==0) newPrim = new CSPrimMultiBox(clParaSet,prop);
-		else if (strcmp(cPrim,"Sphere")==0) newPrim = new CSPrimSphere(clParaSet,prop);
-		else if (strcmp(cPrim,"SphericalShell")==0) newPrim = new CSPrimSphericalShell(clParaSet,prop);
-		else if (strcmp(cPrim,"Cylinder")==0) newPrim = new CSPrimCylinder(clParaSet,prop);
-		else if (strcmp(cPrim,"CylindricalShell")==0) newPrim = new CSPrimCylindricalShell(clParaSet,prop);
-		else if (strcmp(cPrim,"Polygon")==0) newPrim = new CSPrimPolygon(clParaSet,prop);
-		else if (strcmp(cPrim,"LinPoly")==0) newPrim = new CSPrimLinPoly(clParaSet,prop);
-		else if (strcmp(cPrim,"RotPoly")==0) newPrim = new CSPrimRotPoly(clParaSet,prop);
-		else if (strcmp(cPrim,"Polyhedron")==0) newPrim = new CSPrimPolyhedron(clParaSet,prop);
-		else if (strcmp(cPrim,"PolyhedronReader")==0) newPrim = new CSPrimPolyhedronReader(clParaSet,prop);
-		else if (strcmp(cPrim,"Curve")==0) newPrim = new CSPrimCurve(clParaSet,prop);
-		else if (strcmp(cPrim,"Wire")==0) newPrim = new CSPrimWire(clParaSet,prop);
-		else if (strcmp(cPrim,"UserDefined")==0) newPrim = new CSPrimUserDefined(clParaSet,prop);
-		else if (strcmp(cPrim,"Point")==0) newPrim = new CSPrimPoint(clParaSet,prop);
-		else
+		ReadPrimitive(PrimNode,prop);
+		PrimNode=PrimNode->NextSiblingElement();
+	}
+
+	return true;
+}
+
+CSPrimitives* ContinuousStructure::ReadPrimitive(TiXmlElement* PrimNode, CSProperties* prop)
+{
+	const char* cPrim=PrimNode->Value();
+	CSPrimitives* newPrim = CreatePrimitive(cPrim,clParaSet,prop);
+	if (newPrim==NULL)
+	{
+		cerr << "ContinuousStructure::ReadFromXML: Primitive with type: " << cPrim << " is unknown... " << endl;
+		return NULL;
+	}
+	CSPrimPolyhedron* polyhedron = newPrim->ToPolyhedron();
+	if (polyhedron==NULL)
+		polyhedron = newPrim->ToPolyhedronReader();
+	if (polyhedron && (m_NumThreads>1))
+		polyhedron->SetDeferTreeBuild(true);
+	if (newPrim->ReadFromXML(*PrimNode) && ReadHDF5Geometry(PrimNode,newPrim))
+	{
+		newPrim->SetCoordInputType(m_MeshType, false);
+		newPrim->Update(&ErrString);
+		if (polyhedron && polyhedron->GetDeferTreeBuild())
+			m_PendingTrees.push_back(polyhedron);
+		return newPrim;
+	}
+	delete newPrim;
+	ErrString.append("Warning: Invalid primitive found in property: ");
+	ErrString.append(prop->GetName());
+	ErrString.append("!\n");
+	return NULL;
+}
+
+const char* ContinuousStructure::ReadFromXML(const char* file)
+{
+	ErrString.clear();
+
+	string cache_file;
+	if (m_CacheDir.empty()==false)
+	{
+		cache_file = GetCacheFile(file);
+		if (cache_file.empty()==false && ReadFromCache(cache_file))
+			return ErrString.c_str();
+	}
+
+	TiXmlDocument doc(file);
+	if (IsGZipFile(file))
+	{
+		string content;
+		if (ReadGZipFile(file,content)==false) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+		doc.Parse(content.c_str());
+		if (doc.Error()) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+	}
+	else if (!doc.LoadFile()) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+
+	ReadFromXML(&doc);
+	if (cache_file.empty()==false && (ErrString.find("Error")==string::npos))
+		Write2Cache(cache_file);
+	return ErrString.c_str();
+}
+
+string ContinuousStructure::GetCacheFile(const char* file)
+{
+	uint64_t hash;
+	if (HashFile(file,hash)==false)
+		return string();
+	char name[32];
+	snprintf(name,sizeof(name),"%016llx.h5",(unsigned long long)hash);
+	return m_CacheDir + "/" + name;
+}
+
+string ContinuousStructure::GetCacheDependencies()
+{
+	// all files which content is included in the cache, i.e. the imported polyhedrons
+	string deps;
+	const vector<CSPrimitives*> &vPrimitives=GetPrimitiveTable();
+	for (size_t i=0;i<vPrimitives.size();++i)
+	{
+		// the prototype of an instance and the primitives of a CSG may be imported as well
+		vector<CSPrimitives*> prims(1,vPrimitives.at(i));
+		for (size_t n=0;n<prims.size();++n)
 		{
-			cerr << "ContinuousStructure::ReadFromXML: Primitive with type: " << cPrim << " is unknown... " << endl;
-			newPrim=NULL;
+			if (prims.at(n)->ToInstance() && prims.at(n)->ToInstance()->GetPrototype())
+				prims.push_back(prims.at(n)->ToInstance()->GetPrototype());
+			if (prims.at(n)->ToCSG())
+				for (size_t m=0;m<prims.at(n)->ToCSG()->GetQtyPrimitives();++m)
+					prims.push_back(prims.at(n)->ToCSG()->GetPrimitive(m));
 		}
-		if (newPrim)
+		for (size_t n=0;n<prims.size();++n)
 		{
-			if (newPrim->ReadFromXML(*PrimNode))
+			CSPrimPolyhedronReader* reader = prims.at(n)->ToPolyhedronReader();
+			if (reader==NULL)
+				continue;
+			uint64_t hash;
+			if (HashFile(reader->GetFilename().c_str(),hash)==false)
+				return string();
+			char hash_str[32];
+			snprintf(hash_str,sizeof(hash_str),"%016llx ",(unsigned long long)hash);
+			deps += hash_str + reader->GetFilename() + "\n";
+		}
+	}
+	return deps;
+}
+
+bool ContinuousStructure::ReadFromCache(const string &cache_file)
+{
+	FILE* fp = fopen(cache_file.c_str(),"rb");
+	if (fp==NULL)
+		return false;
+	fclose(fp);
+
+	// check that none of the included files has changed
+	hid_t file_id = H5Fopen(cache_file.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (file_id<0)
+		return false;
+	hsize_t dims[1];
+	H5T_class_t class_id;
+	size_t type_size;
+	if (H5LTget_dataset_info(file_id, "/Dependencies", dims, &class_id, &type_size)<0)
+	{
+		H5Fclose(file_id);
+		return false;
+	}
+	vector<char> deps(dims[0]+1,0);
+	bool ok = H5LTread_dataset_char(file_id, "/Dependencies", &deps[0])>=0;
+	H5Fclose(file_id);
+	if (ok==false)
+		return false;
+
+	vector<string> lines = SplitString2Vector(string(&deps[0]),'\n');
+	for (size_t n=0;n<lines.size();++n)
+	{
+		uint64_t hash;
+		if ((lines.at(n).size()<18) || (HashFile(lines.at(n).substr(17).c_str(),hash)==false))
+			return false;
+		char hash_str[32];
+		snprintf(hash_str,sizeof(hash_str),"%016llx",(unsigned long long)hash);
+		if (lines.at(n).compare(0,16,hash_str)!=0)
+			return false;
+	}
+
+	ReadFromHDF5(cache_file.c_str());
+	if (ErrString.find("Error")==string::npos)
+		return true;
+	// fall back to the xml file
+	clear();
+	ErrString.clear();
+	return false;
+}
+
+//! Create a new empty file with a unique name in the directory of the given file. \return The name of the file, empty on error.
+static string CreateUniqueFile(const string &file)
+{
+#if defined(WIN32)
+	// no mkstemp available, the process ID and a counter are unique on this host
+	static boost::mutex counter_mutex;
+	static unsigned int counter = 0;
+	unsigned int cnt;
+	{
+		boost::mutex::scoped_lock lock(counter_mutex);
+		cnt = ++counter;
+	}
+	stringstream name;
+	name << file << ".tmp." << _getpid() << "." << cnt;
+	FILE* fp = fopen(name.str().c_str(),"wb");
+	if (fp==NULL)
+		return string();
+	fclose(fp);
+	return name.str();
+#else
+	string name = file + ".tmp.XXXXXX";
+	vector<char> buf(name.begin(),name.end());
+	buf.push_back(0);
+	int fd = mkstemp(&buf[0]);
+	if (fd<0)
+		return string();
+	close(fd);
+	return string(&buf[0]);
+#endif
+}
+
+bool ContinuousStructure::Write2Cache(const string &cache_file)
+{
+	string deps = GetCacheDependencies();
+	// write to a uniquely named temporary file first, a concurrent reader must never see an incomplete cache file
+	// and concurrent writers (e.g. MPI ranks) must not write into the same temporary file
+	string tmp_file = CreateUniqueFile(cache_file);
+	if (tmp_file.empty())
+	{
+		cerr << __func__ << ": Warning, failed to create a temporary file for: " << cache_file << endl;
+		return false;
+	}
+	if (Write2HDF5(tmp_file.c_str())==false)
+	{
+		remove(tmp_file.c_str());
+		return false;
+	}
+	hid_t file_id = H5Fopen(tmp_file.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+	bool ok = (file_id>=0);
+	if (ok)
+	{
+		hsize_t dims[1] = {deps.size()+1};
+		ok = H5LTmake_dataset_char(file_id, "/Dependencies", 1, dims, deps.c_str())>=0;
+		H5Fclose(file_id);
+	}
+	if (ok==false)
+	{
+		cerr << __func__ << ": Warning, failed to write cache file: " << cache_file << endl;
+		remove(tmp_file.c_str());
+		return false;
+	}
+	if (rename(tmp_file.c_str(),cache_file.c_str())!=0)
+	{
+		// soft error, e.g. a concurrent writer has created the cache file first (rename does not replace a file on Windows)
+		remove(tmp_file.c_str());
+		struct stat info;
+		if (stat(cache_file.c_str(),&info)==0)
+			return true;
+		cerr << __func__ << ": Warning, failed to rename the temporary cache file: " << tmp_file << endl;
+		return false;
+	}
+	return true;
+}
+
+bool ContinuousStructure::Write2HDF5(const char* file, bool parameterised, bool sparse)
+{
+	TiXmlDocument doc;
+	if (Write2XML(&doc,parameterised,sparse)==false) return false;
+
+	hid_t file_id = H5Fcreate(file, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	if (file_id<0)
+	{
+		cerr << __func__ << ": Error, failed to create file: " << file << endl;
+		return false;
+	}
+	double ver = CSXCAD_HDF5_VERSION;
+	H5LTset_attribute_double(file_id, "/", "Version", &ver, 1);
+	hid_t geom_id = H5Gcreate2(file_id, "/Geometry", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	// move the bulk geometry out of the xml, properties and primitives are written in the same order as stored
+	bool ok = (geom_id>=0);
+	unsigned int geom_cnt = 0;
+	TiXmlNode* props = doc.FirstChild("ContinuousStructure")->FirstChild("Properties");
+	TiXmlElement* PropNode = props->FirstChildElement();
+	for (size_t p=0;(p<vProperties.size()) && (PropNode!=NULL) && ok;++p)
+	{
+		TiXmlElement* PrimNode = PropNode->FirstChild("Primitives")->FirstChildElement();
+		for (size_t n=0;(n<vProperties.at(p)->GetQtyPrimitives()) && (PrimNode!=NULL) && ok;++n)
+		{
+			CSPrimitives* prim = vProperties.at(p)->GetPrimitive(n);
+			CSPrimPolyhedron* polyhedron = prim->ToPolyhedron();
+			// imported polyhedrons are stored as well, the file does not depend on the STL/PLY files
+			if (polyhedron==NULL)
+				polyhedron = prim->ToPolyhedronReader();
+			CSPrimMultiBox* multibox = prim->ToMultiBox();
+			if (multibox)
+			{
+				// only store the coordinates as values, if no parameter or expression needs to be kept
+				for (size_t i=0;(i<6*multibox->GetQtyBoxes()) && multibox;++i)
+					if (parameterised && multibox->GetCoordPS(i)->GetMode())
+						multibox=NULL;
+			}
+			if ((polyhedron==NULL) && (multibox==NULL))
+			{
+				PrimNode = PrimNode->NextSiblingElement();
+				continue;
+			}
+
+			string name = "/Geometry/" + ConvertInt(geom_cnt++);
+			hid_t group_id = H5Gcreate2(file_id, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+			if (group_id<0)
+			{
+				ok = false;
+				break;
+			}
+			if (polyhedron)
 			{
-				newPrim->SetCoordInputType(m_MeshType, false);
-				newPrim->Update(&ErrString);
+				hsize_t v_dims[2] = {polyhedron->GetNumVertices(), 3};
+				vector<float> vertices(3*v_dims[0]+1);
+				for (unsigned int i=0;i<polyhedron->GetNumVertices();++i)
+					for (int d=0;d<3;++d)
+						vertices.at(3*i+d) = polyhedron->GetVertex(i)[d];
+				hsize_t f_dims[1] = {polyhedron->GetNumFaces()};
+				vector<int> face_size(f_dims[0]+1);
+				vector<int> faces;
+				for (unsigned int i=0;i<polyhedron->GetNumFaces();++i)
+				{
+					unsigned int numVertices;
+					int* face = polyhedron->GetFace(i,numVertices);
+					face_size.at(i) = numVertices;
+					faces.insert(faces.end(),face,face+numVertices);
+				}
+				hsize_t fv_dims[1] = {faces.size()};
+				faces.push_back(0);
+				ok &= H5LTmake_dataset_float(group_id, "Vertices", 2, v_dims, &vertices[0])>=0;
+				ok &= H5LTmake_dataset_int(group_id, "FaceSize", 1, f_dims, &face_size[0])>=0;
+				ok &= H5LTmake_dataset_int(group_id, "FaceVertices", 1, fv_dims, &faces[0])>=0;
+				while (TiXmlNode* child = PrimNode->FirstChild("Vertex"))
+					PrimNode->RemoveChild(child);
+				while (TiXmlNode* child = PrimNode->FirstChild("Face"))
+					PrimNode->RemoveChild(child);
 			}
 			else
 			{
-				delete newPrim;
-				ErrString.append("Warning: Invalid primitive found in property: ");
-				ErrString.append(prop->GetName());
-				ErrString.append("!\n");
+				hsize_t dims[2] = {multibox->GetQtyBoxes(), 6};
+				vector<double> coords(6*dims[0]+1);
+				for (size_t i=0;i<6*dims[0];++i)
+					coords.at(i) = multibox->GetCoord(i);
+				ok &= H5LTmake_dataset_double(group_id, "Coords", 2, dims, &coords[0])>=0;
+				while (TiXmlNode* child = PrimNode->FirstChild("StartP"))
+					PrimNode->RemoveChild(child);
+				while (TiXmlNode* child = PrimNode->FirstChild("EndP"))
+					PrimNode->RemoveChild(child);
 			}
+			H5Gclose(group_id);
+			PrimNode->SetAttribute("HDF5_Geometry",name.c_str());
+			PrimNode = PrimNode->NextSiblingElement();
 		}
-		PrimNode=PrimNode->NextSiblingElement();
+		PropNode = PropNode->NextSiblingElement();
 	}
+	if (geom_id>=0)
+		H5Gclose(geom_id);
 
-	return true;
+	if (ok)
+	{
+		TiXmlPrinter printer;
+		doc.Accept(&printer);
+		hsize_t dims[1] = {printer.Size()+1};
+		ok = H5LTmake_dataset_char(file_id, "/XML", 1, dims, printer.CStr())>=0;
+	}
+	H5Fclose(file_id);
+	if (!ok)
+		cerr << __func__ << ": Error, failed to write structure to file: " << file << endl;
+	return ok;
 }
 
-const char* ContinuousStructure::ReadFromXML(const char* file)
+const char* ContinuousStructure::ReadFromHDF5(const char* file)
 {
 	ErrString.clear();
 
-	TiXmlDocument doc(file);
-	if (!doc.LoadFile()) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+	hid_t file_id = H5Fopen(file, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (file_id<0) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+
+	double ver = 0;
+	if ((H5LTget_attribute_double(file_id, "/", "Version", &ver)<0) || (ver>CSXCAD_HDF5_VERSION))
+	{
+		ErrString.append("Error: Unknown or unsupported HDF5 structure file version!!! File: ");ErrString.append(file);
+		H5Fclose(file_id);
+		return ErrString.c_str();
+	}
+
+	hsize_t dims[1];
+	H5T_class_t class_id;
+	size_t type_size;
+	if (H5LTget_dataset_info(file_id, "/XML", dims, &class_id, &type_size)<0)
+	{
+		ErrString.append("Error: No structure found in HDF5 file!!! File: ");ErrString.append(file);
+		H5Fclose(file_id);
+		return ErrString.c_str();
+	}
+	vector<char> xml(dims[0]+1,0);
+	H5LTread_dataset_char(file_id, "/XML", &xml[0]);
+
+	TiXmlDocument doc;
+	doc.Parse(&xml[0]);
+	if (doc.Error())
+	{
+		ErrString.append("Error: Parsing the structure failed!!! File: ");ErrString.append(file);
+		H5Fclose(file_id);
+		return ErrString.c_str();
+	}
+	xml.clear();
+
+	CSHDF5Reader reader;
+	reader.file_id = file_id;
+	m_HDF5_Reader = &reader;
+	ReadFromXML(&doc);
+	m_HDF5_Reader = NULL;
+	H5Fclose(file_id);
+	return ErrString.c_str();
+}
+
+bool ContinuousStructure::ReadHDF5Geometry(TiXmlElement* PrimNode, CSPrimitives* prim)
+{
+	const char* name = PrimNode->Attribute("HDF5_Geometry");
+	if (name==NULL)
+		return true;
+	if (m_HDF5_Reader==NULL)
+	{
+		cerr << __func__ << ": Error, primitive geometry is stored in a HDF5 file, use ReadFromHDF5 to read this structure!" << endl;
+		return false;
+	}
+	hid_t file_id = m_HDF5_Reader->file_id;
+	hsize_t dims[2];
+	H5T_class_t class_id;
+	size_t type_size;
+
+	CSPrimPolyhedron* polyhedron = prim->ToPolyhedron();
+	if (polyhedron==NULL)
+		polyhedron = prim->ToPolyhedronReader();
+	if (polyhedron)
+	{
+		string v_name = string(name) + "/Vertices";
+		string fs_name = string(name) + "/FaceSize";
+		string fv_name = string(name) + "/FaceVertices";
+		if (H5LTget_dataset_info(file_id, v_name.c_str(), dims, &class_id, &type_size)<0)
+			return false;
+		vector<float> vertices(dims[0]*3+1);
+		if (H5LTread_dataset_float(file_id, v_name.c_str(), &vertices[0])<0)
+			return false;
+		unsigned int numVertices = dims[0];
+		if (H5LTget_dataset_info(file_id, fs_name.c_str(), dims, &class_id, &type_size)<0)
+			return false;
+		vector<int> face_size(dims[0]+1);
+		if (H5LTread_dataset_int(file_id, fs_name.c_str(), &face_size[0])<0)
+			return false;
+		unsigned int numFaces = dims[0];
+		if (H5LTget_dataset_info(file_id, fv_name.c_str(), dims, &class_id, &type_size)<0)
+			return false;
+		vector<int> faces(dims[0]+1);
+		if (H5LTread_dataset_int(file_id, fv_name.c_str(), &faces[0])<0)
+			return false;
+
+		polyhedron->Reset();
+		for (unsigned int i=0;i<numVertices;++i)
+			polyhedron->AddVertex(&vertices[3*i]);
+		size_t offset=0;
+		for (unsigned int i=0;i<numFaces;++i)
+		{
+			if (offset+face_size.at(i)>dims[0])
+				return false;
+			polyhedron->AddFace(face_size.at(i),&faces[offset]);
+			offset+=face_size.at(i);
+		}
+		if (polyhedron->GetDeferTreeBuild())
+			return true;
+		return polyhedron->BuildTree();
+	}
+
+	CSPrimMultiBox* multibox = prim->ToMultiBox();
+	if (multibox)
+	{
+		string c_name = string(name) + "/Coords";
+		if (H5LTget_dataset_info(file_id, c_name.c_str(), dims, &class_id, &type_size)<0)
+			return false;
+		vector<double> coords(dims[0]*6+1);
+		if (H5LTread_dataset_double(file_id, c_name.c_str(), &coords[0])<0)
+			return false;
+		for (size_t i=0;i<dims[0]*6;++i)
+			multibox->AddCoord(coords.at(i));
+		return true;
+	}
+
+	cerr << __func__ << ": Error, unexpected HDF5 geometry for primitive type: " << prim->GetTypeName() << endl;
+	return false;
+}
+
+bool ContinuousStructure::ReadStreamElement(CSXMLStreamScanner &scanner, streamoff start, streamoff end, TiXmlDocument &doc)
+{
+	string content;
+	doc.Clear();
+	if (scanner.GetRange(start,end,content)==false)
+		return false;
+	doc.Parse(content.c_str());
+	return (doc.Error()==false) && (doc.FirstChildElement()!=NULL);
+}
+
+bool ContinuousStructure::ReadStreamPrimitives(CSXMLStreamScanner &scanner, streamoff start, CSProperties* prop)
+{
+	string name;
+	streamoff tag_start=0, tag_end=0, prim_start=0;
+	if ((scanner.Seek(start)==false) || (scanner.Next(name,tag_start,tag_end)!=CSXMLStreamScanner::START_TAG))
+		return false;
+	TiXmlDocument doc;
+	CSXMLStreamScanner::TokenType token;
+	while (true)
+	{
+		token = scanner.Next(name,tag_start,tag_end);
+		if ((token==CSXMLStreamScanner::END_OF_FILE) || (token==CSXMLStreamScanner::TOKEN_ERROR))
+			return false;
+		int depth = scanner.GetDepth();
+		if (depth<1)
+			return true; // end of the primitives
+		if ((token==CSXMLStreamScanner::START_TAG) && (depth==2))
+		{
+			prim_start = tag_start;
+			continue;
+		}
+		if ((token==CSXMLStreamScanner::EMPTY_TAG) && (depth==1))
+			prim_start = tag_start;
+		else if ((token!=CSXMLStreamScanner::END_TAG) || (depth!=1))
+			continue;
+
+		// a complete primitive
+		if (ReadStreamElement(scanner,prim_start,tag_end,doc))
+			ReadPrimitive(doc.FirstChildElement(),prop);
+		else
+		{
+			ErrString.append("Warning: Invalid primitive found in property: ");
+			ErrString.append(prop->GetName());
+			ErrString.append("!\n");
+		}
+		doc.Clear();
+	}
+}
+
+bool ContinuousStructure::ReadStreamProperty(CSXMLStreamScanner &scanner, CSXMLStreamScanner &prim_scanner, const string &name, streamoff start, streamoff end, bool empty, CSProperties* &prop)
+{
+	prop = NULL;
+	// collect the property without its primitives, the material values may follow the primitives
+	string header, content;
+	if (scanner.GetRange(start,end,header)==false)
+		return false;
+	string child;
+	streamoff tag_start=0, tag_end=0, child_start=0, prims_start=-1;
+	bool skip_child = false;
+	int prop_depth = scanner.GetDepth();
+	CSXMLStreamScanner::TokenType token;
+	while (empty==false)
+	{
+		token = scanner.Next(child,tag_start,tag_end);
+		if ((token==CSXMLStreamScanner::END_OF_FILE) || (token==CSXMLStreamScanner::TOKEN_ERROR))
+			return false;
+		int depth = scanner.GetDepth();
+		if (depth<prop_depth)
+			break; // end of the property
+		if ((token==CSXMLStreamScanner::START_TAG) && (depth==prop_depth+1))
+		{
+			child_start = tag_start;
+			skip_child = (child.compare("Primitives")==0);
+			if (skip_child && (prims_start<0))
+				prims_start = tag_start;
+			continue;
+		}
+		if ((token==CSXMLStreamScanner::EMPTY_TAG) && (depth==prop_depth))
+			child_start = tag_start;
+		else if ((token!=CSXMLStreamScanner::END_TAG) || (depth!=prop_depth) || skip_child)
+			continue;
+		if (scanner.GetRange(child_start,tag_end,content)==false)
+			return false;
+		header.append(content);
+	}
+	if (empty==false)
+		header.append("</" + name + ">");
+
+	TiXmlDocument doc;
+	doc.Parse(header.c_str());
+	header.clear();
+	if (doc.Error() || (doc.FirstChildElement()==NULL))
+	{
+		ErrString.append("Warning: invalid Property found!!!\n");
+		return true;
+	}
+	prop = ReadProperty(doc.FirstChildElement(),prims_start<0);
+	doc.Clear();
+	if ((prop==NULL) || (prims_start<0))
+		return true;
+	return ReadStreamPrimitives(prim_scanner,prims_start,prop);
+}
+
+const char* ContinuousStructure::ReadFromXMLStream(const char* file, PropertyCallback callback, void* userData)
+{
+	clear();
+	ErrString.clear();
+	CSArena::Scope arena_scope(m_Arena);
+
+	// a second scanner follows the primitives of the current property
+	CSXMLStreamScanner scanner, prim_scanner;
+	if ((scanner.Open(file)==false) || (prim_scanner.Open(file)==false)) { ErrString.append("Error: File-Loading failed!!! File: ");ErrString.append(file); return ErrString.c_str();}
+
+	string name;
+	streamoff start=0, end=0;
+	streamoff elem_start=0;
+	int root_depth = -1;
+	bool in_props = false, props_found = false, grid_found = false, abort = false;
+	vector<streamoff> deferred; // start offsets of properties found before the grid
+	TiXmlDocument doc;
+	CSXMLStreamScanner::TokenType token;
+	while ((abort==false) && ((token=scanner.Next(name,start,end))!=CSXMLStreamScanner::END_OF_FILE))
+	{
+		if (token==CSXMLStreamScanner::TOKEN_ERROR)
+		{
+			ErrString.append("Error: XML parsing failed!!! File: ");ErrString.append(file);
+			return ErrString.c_str();
+		}
+		int depth = scanner.GetDepth();
+		if (root_depth<0)
+		{
+			// search for the structure, it may be embedded in another document
+			if ((token==CSXMLStreamScanner::END_TAG) || (name.compare("ContinuousStructure")!=0))
+				continue;
+			string content;
+			scanner.GetRange(start,end,content);
+			if (token==CSXMLStreamScanner::START_TAG)
+				content.append("</ContinuousStructure>");
+			doc.Clear();
+			doc.Parse(content.c_str());
+			int CS_mesh = 0;
+			if (doc.FirstChildElement() && (doc.FirstChildElement()->QueryIntAttribute("CoordSystem",&CS_mesh) == TIXML_SUCCESS))
+				SetCoordInputType((CoordinateSystem)CS_mesh);
+			if (token==CSXMLStreamScanner::EMPTY_TAG)
+				break;
+			root_depth = depth;
+			continue;
+		}
+
+		if (in_props)
+		{
+			if ((token==CSXMLStreamScanner::END_TAG) && (depth==root_depth))
+				in_props = false;
+			bool prop_tag = ((token==CSXMLStreamScanner::START_TAG) && (depth==root_depth+2)) || ((token==CSXMLStreamScanner::EMPTY_TAG) && (depth==root_depth+1));
+			if (prop_tag==false)
+				continue;
+
+			if (grid_found==false)
+			{
+				deferred.push_back(start);
+				continue;
+			}
+			CSProperties* prop = NULL;
+			if (ReadStreamProperty(scanner,prim_scanner,name,start,end,token==CSXMLStreamScanner::EMPTY_TAG,prop)==false)
+			{
+				ErrString.append("Error: XML parsing failed!!! File: ");ErrString.append(file);
+				return ErrString.c_str();
+			}
+			if (prop && callback)
+			{
+				BuildPendingTrees();
+				abort = (callback(this,prop,userData)==false);
+			}
+			continue;
+		}
+
+		if (depth<root_depth)
+			break; // end of structure
+		if ((token==CSXMLStreamScanner::START_TAG) && (depth==root_depth+1))
+		{
+			elem_start = start;
+			if (name.compare("Properties")==0)
+				in_props = props_found = true;
+			continue;
+		}
+		if (token==CSXMLStreamScanner::EMPTY_TAG)
+		{
+			if (depth!=root_depth)
+				continue;
+			elem_start = start;
+			if (name.compare("Properties")==0)
+				props_found = true;
+		}
+		else if ((token!=CSXMLStreamScanner::END_TAG) || (depth!=root_depth))
+			continue;
+
+		// a complete child element of the structure
+		if (ReadStreamElement(scanner,elem_start,end,doc)==false)
+			continue;
+		TiXmlElement* elem = doc.FirstChildElement();
+		if (name.compare("RectilinearGrid")==0)
+		{
+			if (clGrid.ReadFromXML(*elem)==false) { ErrString.append("Error: RectilinearGrid invalid!!!\n"); return ErrString.c_str();}
+			grid_found = true;
+		}
+		else if (name.compare("BackgroundMaterial")==0)
+		{
+			if (m_BG_Mat.ReadFromXML(*elem)==false)
+			{
+				ErrString.append("Error: BackgroundMaterial invalid!!!\n");
+				return ErrString.c_str();
+			}
+		}
+		else if (name.compare("ParameterSet")==0)
+		{
+			if (clParaSet->ReadFromXML(*elem)==false) { ErrString.append("Warning: ParameterSet reading failed!!!\n");}
+		}
+		doc.Clear();
+	}
+
+	if (root_depth<0) { ErrString.append("Error: No ContinuousStructure found!!!\n"); return ErrString.c_str();}
+	if (grid_found==false) { ErrString.append("Error: No RectilinearGrid found!!!\n"); return ErrString.c_str();}
+	if (props_found==false) { ErrString.append("Warning: Properties not found!!!\n"); return ErrString.c_str();}
+
+	// scan the properties found before the grid once more
+	for (size_t n=0;(n<deferred.size()) && (abort==false);++n)
+	{
+		CSProperties* prop = NULL;
+		if ((scanner.Seek(deferred.at(n))==false) || ((token=scanner.Next(name,start,end))==CSXMLStreamScanner::END_OF_FILE) || (token==CSXMLStreamScanner::TOKEN_ERROR) ||
+				(ReadStreamProperty(scanner,prim_scanner,name,start,end,token==CSXMLStreamScanner::EMPTY_TAG,prop)==false))
+		{
+			ErrString.append("Error: XML parsing failed!!! File: ");ErrString.append(file);
+			return ErrString.c_str();
+		}
+		if (prop && callback)
+		{
+			BuildPendingTrees();
+			abort = (callback(this,prop,userData)==false);
+		}
+	}
+	BuildPendingTrees();
+	return ErrString.c_str();
+}
+
+//! Worker building the search trees (and reading the files of polyhedron readers) of every n-th pending polyhedron.
+struct CSTreeBuildWorker
+{
+	vector<CSPrimPolyhedron*>* polyhedrons;
+	const vector<double>* rnd;
+	//! Result of every polyhedron, a char per entry as concurrent writes to a vector<bool> are not safe.
+	vector<char>* ok;
+	size_t start;
+	size_t step;
+	void operator()()
+	{
+		for (size_t n=start;n<polyhedrons->size();n+=step)
+			ok->at(n) = polyhedrons->at(n)->BuildTree(&rnd->at(3*n));
+	}
+};
 
-	return ReadFromXML(&doc);
+void ContinuousStructure::BuildPendingTrees()
+{
+	if (m_PendingTrees.size()==0)
+		return;
+
+	// draw the random reference points in document order, the result does not depend on the thread scheduling
+	vector<double> rnd(3*m_PendingTrees.size());
+	for (size_t n=0;n<rnd.size();++n)
+		rnd.at(n) = (double)rand()/RAND_MAX;
+
+	size_t numThreads = m_NumThreads;
+	if (numThreads>m_PendingTrees.size())
+		numThreads = m_PendingTrees.size();
+	if (numThreads<1)
+		numThreads = 1;
+
+	vector<char> ok(m_PendingTrees.size(),0);
+	boost::thread_group threads;
+	for (size_t t=0;t<numThreads;++t)
+	{
+		CSTreeBuildWorker worker;
+		worker.polyhedrons = &m_PendingTrees;
+		worker.rnd = &rnd;
+		worker.ok = &ok;
+		worker.start = t;
+		worker.step = numThreads;
+		if (t==numThreads-1)
+			worker(); // use the calling thread for the last share
+		else
+			threads.create_thread(worker);
+	}
+	threads.join_all();
+
+	for (size_t n=0;n<m_PendingTrees.size();++n)
+	{
+		CSPrimPolyhedron* polyhedron = m_PendingTrees.at(n);
+		polyhedron->SetDeferTreeBuild(false);
+		if (ok.at(n))
+			continue;
+		// e.g. the file of a polyhedron reader was not found, remove it like any invalid primitive
+		CSProperties* prop = polyhedron->GetProperty();
+		ErrString.append("Warning: Invalid primitive found in property: ");
+		if (prop)
+			ErrString.append(prop->GetName());
+		ErrString.append("!\n");
+		if (prop)
+			prop->DeletePrimitive(polyhedron);
+		else
+			delete polyhedron;
+	}
+	m_PendingTrees.clear();
 }
 
 void ContinuousStructure::UpdateIDs()
@@ -593,6 +1560,171 @@ void ContinuousStructure::UpdateIDs()
 		vProperties.at(i)->SetID((unsigned int)i);
 }
 
+void ContinuousStructure::UpdateIndex()
+{
+	if (m_IndexValid)
+		return;
+	m_PrimIDIndex.clear();
+	m_PropNameIndex.clear();
+	m_PrimPropIndex.clear();
+	m_PrimTable.clear();
+	m_PrimTypeTable.clear();
+	for (size_t i=0;i<vProperties.size();++i)
+		AddToIndex(vProperties.at(i));
+	m_IndexValid = true;
+	m_PrimTableValid = true;
+}
+
+void ContinuousStructure::UpdatePrimTable()
+{
+	UpdateIndex();
+	if (m_PrimTableValid)
+		return;
+	m_PrimTable.clear();
+	m_PrimTypeTable.clear();
+	for (size_t i=0;i<vProperties.size();++i)
+	{
+		const vector<CSPrimitives*> &prims = vProperties.at(i)->GetPrimitiveTable();
+		m_PrimTable.insert(m_PrimTable.end(),prims.begin(),prims.end());
+	}
+	m_PrimTableValid = true;
+}
+
+void ContinuousStructure::AddToIndex(CSProperties* prop)
+{
+	// multimaps keep the insertion order of equal keys, thus the first match is the first in property order
+	m_PropNameIndex.insert(pair<string, CSProperties*>(prop->GetName(),prop));
+	for (size_t n=0;n<prop->GetQtyPrimitives();++n)
+	{
+		CSPrimitives* prim = prop->GetPrimitive(n);
+		m_PrimIDIndex.insert(pair<unsigned int, CSPrimitives*>(prim->GetID(),prim));
+		m_PrimPropIndex[prim] = prop;
+		m_PrimTable.push_back(prim);
+		map<int, vector<CSPrimitives*> >::iterator it = m_PrimTypeTable.find(prim->GetType());
+		if (it!=m_PrimTypeTable.end())
+			it->second.push_back(prim);
+	}
+}
+
+void ContinuousStructure::RemoveFromIndex(CSProperties* prop)
+{
+	pair<multimap<string, CSProperties*>::iterator, multimap<string, CSProperties*>::iterator> range = m_PropNameIndex.equal_range(prop->GetName());
+	for (multimap<string, CSProperties*>::iterator it=range.first;it!=range.second;++it)
+	{
+		if (it->second==prop)
+		{
+			m_PropNameIndex.erase(it);
+			break;
+		}
+	}
+	if (prop->GetQtyPrimitives()==0)
+		return;
+	for (size_t n=0;n<prop->GetQtyPrimitives();++n)
+		RemoveFromIndex(prop->GetPrimitive(n),false);
+
+	// remove all primitives of this property from the primitive table in a single pass
+	size_t count=0;
+	for (size_t i=0;i<m_PrimTable.size();++i)
+		if (m_PrimPropIndex.find(m_PrimTable.at(i))!=m_PrimPropIndex.end())
+			m_PrimTable.at(count++) = m_PrimTable.at(i);
+	m_PrimTable.resize(count);
+	// type tables are rebuilt on demand
+	m_PrimTypeTable.clear();
+}
+
+void ContinuousStructure::RemoveFromIndex(CSPrimitives* prim, bool update_tables)
+{
+	if (prim==NULL)
+		return;
+	m_PrimPropIndex.erase(prim);
+	pair<multimap<unsigned int, CSPrimitives*>::iterator, multimap<unsigned int, CSPrimitives*>::iterator> range = m_PrimIDIndex.equal_range(prim->GetID());
+	for (multimap<unsigned int, CSPrimitives*>::iterator it=range.first;it!=range.second;++it)
+	{
+		if (it->second==prim)
+		{
+			m_PrimIDIndex.erase(it);
+			break;
+		}
+	}
+	if ((update_tables==false) || (m_PrimTableValid==false))
+		return;
+	m_PrimTable.erase(remove(m_PrimTable.begin(),m_PrimTable.end(),prim),m_PrimTable.end());
+	map<int, vector<CSPrimitives*> >::iterator type_it = m_PrimTypeTable.find(prim->GetType());
+	if (type_it!=m_PrimTypeTable.end())
+		type_it->second.erase(remove(type_it->second.begin(),type_it->second.end(),prim),type_it->second.end());
+}
+
+void ContinuousStructure::IndexAddPrimitive(CSProperties* prop, CSPrimitives* prim)
+{
+	++m_Revision;
+	if (m_IndexValid==false)
+		return;
+	// the first match of an ID has to be the first in property order, which can't be kept for a primitive of an earlier property
+	bool last = (vProperties.size()>0) && (vProperties.back()==prop);
+	if ((last==false) && (m_PrimIDIndex.find(prim->GetID())!=m_PrimIDIndex.end()))
+	{
+		m_IndexValid = false;
+		return;
+	}
+	m_PrimIDIndex.insert(pair<unsigned int, CSPrimitives*>(prim->GetID(),prim));
+	m_PrimPropIndex[prim] = prop;
+	// a primitive notifies from within its constructor, its type is not known yet and the type tables are rebuilt on demand
+	m_PrimTypeTable.clear();
+	if (last && m_PrimTableValid)
+		m_PrimTable.push_back(prim);
+	else
+		m_PrimTableValid = false;
+}
+
+void ContinuousStructure::IndexRemovePrimitive(CSPrimitives* prim)
+{
+	++m_Revision;
+	if (m_IndexValid)
+		RemoveFromIndex(prim);
+}
+
+void ContinuousStructure::IndexChangePrimitiveID(CSPrimitives* prim, unsigned int oldID)
+{
+	++m_Revision;
+	if (m_IndexValid==false)
+		return;
+	pair<multimap<unsigned int, CSPrimitives*>::iterator, multimap<unsigned int, CSPrimitives*>::iterator> range = m_PrimIDIndex.equal_range(oldID);
+	for (multimap<unsigned int, CSPrimitives*>::iterator it=range.first;it!=range.second;++it)
+	{
+		if (it->second==prim)
+		{
+			m_PrimIDIndex.erase(it);
+			break;
+		}
+	}
+	// a duplicate ID has to be ordered by property order, rebuild
+	if (m_PrimIDIndex.find(prim->GetID())!=m_PrimIDIndex.end())
+		m_IndexValid = false;
+	else
+		m_PrimIDIndex.insert(pair<unsigned int, CSPrimitives*>(prim->GetID(),prim));
+}
+
+void ContinuousStructure::IndexRenameProperty(CSProperties* prop, const string &oldName)
+{
+	++m_Revision;
+	if (m_IndexValid==false)
+		return;
+	pair<multimap<string, CSProperties*>::iterator, multimap<string, CSProperties*>::iterator> range = m_PropNameIndex.equal_range(oldName);
+	for (multimap<string, CSProperties*>::iterator it=range.first;it!=range.second;++it)
+	{
+		if (it->second==prop)
+		{
+			m_PropNameIndex.erase(it);
+			break;
+		}
+	}
+	// a duplicate name has to be ordered by property order, rebuild
+	if (m_PropNameIndex.find(prop->GetName())!=m_PropNameIndex.end())
+		m_IndexValid = false;
+	else
+		m_PropNameIndex.insert(pair<string, CSProperties*>(prop->GetName(),prop));
+}
+
 string ContinuousStructure::GetInfoLine(bool shortInfo)
 {
 	if (shortInfo)
@@ -28,6 +28,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
 #include "CSXCAD_Global.h"
 #include "CSProperties.h"
 #include "CSPrimitives.h"
@@ -37,6 +38,11 @@
 #include "CSUseful.h"
 
 class TiXmlNode;
+class TiXmlElement;
+class TiXmlDocument;
+struct CSHDF5Reader;
+class CSArena;
+class CSXMLStreamScanner;
 
 //! Continuous Structure containing properties (layer) and primitives.
 /*!
@@ -121,6 +127,9 @@ public:
 	//! Find the property owning the given primitive or return NULL if primitive is not to be found
 	CSProperties* HasPrimitive(CSPrimitives* prim);
 
+	//! Get the revision of this structure, changes whenever a property or primitive is added, removed, renamed or moved to another property. \sa CSGeometrySnapshot::IsCurrent
+	unsigned int GetRevision() const {return m_Revision;}
+
 	//! Delete the given primitive
 	void DeletePrimitive(CSPrimitives* prim);
 
@@ -133,6 +142,15 @@ public:
 	//! Get a primitives array of a certian type
 	vector<CSPrimitives*>  GetPrimitivesByType(CSPrimitives::PrimitiveType type);
 
+	//! Get the cached table of all primitives (in property order) without copying.
+	/*!
+	 The table is rebuilt on demand if properties or primitives have been added, removed or moved.
+	 The returned reference (and iterators into it) are invalidated by any such modification, use GetAllPrimitives if primitives are deleted during the iteration.
+	 */
+	const vector<CSPrimitives*>& GetPrimitiveTable();
+	//! Get the cached table of all primitives of a certain type without copying. \sa GetPrimitiveTable
+	const vector<CSPrimitives*>& GetPrimitiveTable(CSPrimitives::PrimitiveType type);
+
 	//! Get the internal index of the property.
 	int GetIndex(CSProperties* prop);
 
@@ -148,9 +166,17 @@ public:
 	//! Get the edges of all includes primitives and add to the desired grid direction. \param nu Direction of grid (x=0,y=1,z=2).
 	bool InsertEdges2Grid(int nu);
 
+	//! Get the mesh resolution in cells per material wavelength for all properties.
+	/*!
+	 For every material property the largest mesh cell inside the bounding boxes of its primitives is compared to the wavelength inside the material (using the max. of the anisotropic epsilon and mue values).
+	 \param freq The frequency of interest in Hz.
+	 \return Cells per wavelength for each property (indexed like GetProperty), 0 for non-material properties or properties without primitives inside the mesh.
+	 */
+	vector<double> GetCellsPerWavelength(double freq);
+
 	//! Check whether the structure is valid.
 	virtual bool isGeometryValid();
-	//! Update all primitives and properties e.g. with respect to changed parameter settings. \return Gives an error message in case of a found error.
+	//! Update all primitives and properties e.g. with respect to changed parameter settings. \return Gives an error message in case of a found error. \sa CSGeometrySnapshot::Freeze
 	const char* Update();
 
 	//! Get an array containing the absolute size of the current structure.
@@ -167,6 +193,7 @@ public:
 	virtual bool Write2XML(TiXmlNode* rootNode, bool parameterised=true, bool sparse=false);
 	//! Write this structure to a file.
 	/*!
+	 A filename ending with ".gz" will create a gzip compressed file.
 	 \param file Filename to write this structure into. Will create a new file or overwrite an existing one!
 	 \param parameterised Include full parameters (default) or parameter-values only.
 	 */
@@ -174,6 +201,7 @@ public:
 
 	//! Read a structure from file.
 	/*!
+	 Gzip compressed files are detected automatically.
 	 \return Will return a string with possible error-messages!
 	 \param file Filename to read this structure from.
 	 */
@@ -185,18 +213,140 @@ public:
 	 */
 	const char* ReadFromXML(TiXmlNode* rootNode);
 
+	//! Write this structure to a binary HDF5 file.
+	/*!
+	 The structure is stored as XML, except the bulk geometry data of polyhedrons and (non-parameterised) multi-boxes.
+	 These are stored as contiguous typed arrays in the group "/Geometry" and referenced from the XML.
+	 \param file Filename to write this structure into. Will create a new file or overwrite an existing one!
+	 \param parameterised Include full parameters (default) or parameter-values only.
+	 */
+	virtual bool Write2HDF5(const char* file, bool parameterised=true, bool sparse=false);
+	//! Read a structure from a binary HDF5 file. \sa Write2HDF5
+	/*!
+	 \return Will return a string with possible error-messages!
+	 \param file Filename to read this structure from.
+	 */
+	const char* ReadFromHDF5(const char* file);
+
+	//! Callback for the streaming reader, called for every completed property. \return false to abort reading. \sa ReadFromXMLStream
+	typedef bool (*PropertyCallback)(ContinuousStructure* csx, CSProperties* prop, void* userData);
+	//! Read a structure from file without loading the whole xml document into memory.
+	/*!
+	 The properties and their primitives are created while the file is read, only a single primitive (or the header of a property) is parsed at a time.
+	 If the properties are found in the file before the grid, they are read after the rest of the structure.
+	 \return Will return a string with possible error-messages!
+	 \param file Filename to read this structure from.
+	 \param callback Optional callback called for every completed property (already added to this structure).
+	 \param userData User data handed to the callback.
+	 */
+	const char* ReadFromXMLStream(const char* file, PropertyCallback callback=NULL, void* userData=NULL);
+
+	//! Set the number of threads used to build the polyhedron search trees while reading a structure (default is 1).
+	/*!
+	 The xml is parsed in document order in any case, thus IDs and priorities do not depend on the number of threads.
+	 */
+	void SetNumberOfThreads(unsigned int val) {m_NumThreads=val;}
+	unsigned int GetNumberOfThreads() const {return m_NumThreads;}
+
+	//! Set a directory to cache structures read from xml files, an empty string disables the cache (default).
+	/*!
+	 The cache directory can also be set using the environment variable CSXCAD_CACHE_DIR.
+	 The structure is cached in the HDF5 format (see Write2HDF5), including the geometry of all imported STL/PLY polyhedrons.
+	 The cache files are named by a hash of the xml file and are used as long as the imported files are unchanged.
+	 \sa ReadFromXML
+	 */
+	void SetCacheDirectory(string dir) {m_CacheDir=dir;}
+	string GetCacheDirectory() const {return m_CacheDir;}
+
 	//! Get a Info-Line containing lib-name, -version etc. 
 	static string GetInfoLine(bool shortInfo=false);
 
+	//! Create a new (empty) primitive by its xml type name, e.g. "Box". \return The new primitive or NULL if the type is unknown.
+	static CSPrimitives* CreatePrimitive(const char* type, ParameterSet* paraSet, CSProperties* prop);
+
 protected:
 	ParameterSet* clParaSet;
 	CSRectGrid clGrid;
 	CSBackgroundMaterial m_BG_Mat;
 	vector<CSProperties*> vProperties;
 	bool ReadPropertyPrimitives(TiXmlElement* PropNode, CSProperties* prop);
+	//! Create a primitive of the given property from the given xml-node. \return The new primitive or NULL.
+	CSPrimitives* ReadPrimitive(TiXmlElement* PrimNode, CSProperties* prop);
+	//! Create a property from the given xml-node and add it to this structure, its primitives are read if requested. \return The new property or NULL.
+	CSProperties* ReadProperty(TiXmlElement* PropNode, bool primitives=true);
+	//! Parse the xml-element between the given file offsets. \sa ReadFromXMLStream
+	bool ReadStreamElement(CSXMLStreamScanner &scanner, streamoff start, streamoff end, TiXmlDocument &doc);
+	//! Read a property from the stream, the scanner has to be positioned right after the given start tag of the property.
+	/*!
+	 The property is created from its start tag and all children except the primitives, which are read afterwards using the primitive scanner.
+	 \return false if the xml is broken, an invalid property is reported in the error string and returned as NULL.
+	 */
+	bool ReadStreamProperty(CSXMLStreamScanner &scanner, CSXMLStreamScanner &prim_scanner, const string &name, streamoff start, streamoff end, bool empty, CSProperties* &prop);
+	//! Read the primitives of the given property one at a time, starting at the given file offset of its Primitives element. \return false if the xml is broken.
+	bool ReadStreamPrimitives(CSXMLStreamScanner &scanner, streamoff start, CSProperties* prop);
+
+	//! Open HDF5 structure file while reading, used to load the bulk geometry data. \sa ReadFromHDF5
+	CSHDF5Reader* m_HDF5_Reader;
+	//! Read the bulk geometry data of a primitive from the open HDF5 structure file.
+	bool ReadHDF5Geometry(TiXmlElement* PrimNode, CSPrimitives* prim);
 
 	void UpdateIDs();
 
+	unsigned int m_NumThreads;
+	string m_CacheDir;
+	//! Get the cache file name for the given xml file. \return An empty string if the file can't be read.
+	string GetCacheFile(const char* file);
+	//! Get the hashes and names of all files included in the cache.
+	string GetCacheDependencies();
+	bool ReadFromCache(const string &cache_file);
+	bool Write2Cache(const string &cache_file);
+
+	//! Polyhedrons read with a deferred search tree build. \sa BuildPendingTrees
+	vector<CSPrimPolyhedron*> m_PendingTrees;
+
+	//! Arena for all properties and primitives read by this structure, replaced by clear(). \sa CSArena
+	CSArena* m_Arena;
+	//! Build the search trees of all pending polyhedrons using up to m_NumThreads threads, polyhedron readers read their files in the same step.
+	/*!
+	 A polyhedron that fails (e.g. a missing file) is deleted and reported as invalid primitive.
+	 */
+	void BuildPendingTrees();
+
+	//! Revision of this structure. \sa GetRevision
+	unsigned int m_Revision;
+
+	//! Lookup indexes for primitive IDs, property names and primitive owners, kept in sync by the Index* notifications. \sa UpdateIndex
+	multimap<unsigned int, CSPrimitives*> m_PrimIDIndex;
+	multimap<string, CSProperties*> m_PropNameIndex;
+	map<CSPrimitives*, CSProperties*> m_PrimPropIndex;
+	bool m_IndexValid;
+	//! Tables of all primitives in property order, rebuilt on demand if a primitive was added to a property other than the last one. \sa UpdatePrimTable
+	vector<CSPrimitives*> m_PrimTable;
+	map<int, vector<CSPrimitives*> > m_PrimTypeTable;
+	bool m_PrimTableValid;
+	//! Rebuild the lookup indexes if necessary.
+	void UpdateIndex();
+	//! Rebuild the lookup indexes and the primitive table if necessary.
+	void UpdatePrimTable();
+	//! Add a property and all its primitives to the lookup indexes.
+	void AddToIndex(CSProperties* prop);
+	//! Remove a property and all its primitives from the lookup indexes.
+	void RemoveFromIndex(CSProperties* prop);
+	//! Remove a primitive from the lookup indexes. \param update_tables Also remove the primitive from the primitive tables.
+	void RemoveFromIndex(CSPrimitives* prim, bool update_tables=true);
+
+	// notifications of the properties (and their primitives) owned by this structure, see CSProperties::SetStructure
+	friend class CSProperties;
+	friend class CSPrimitives;
+	//! A primitive was appended to the given property.
+	void IndexAddPrimitive(CSProperties* prop, CSPrimitives* prim);
+	//! A primitive was removed from its property.
+	void IndexRemovePrimitive(CSPrimitives* prim);
+	//! The ID of a primitive was changed.
+	void IndexChangePrimitiveID(CSPrimitives* prim, unsigned int oldID);
+	//! A property was renamed.
+	void IndexRenameProperty(CSProperties* prop, const string &oldName);
+
 	CoordinateSystem m_MeshType;
 
 	unsigned int maxID;
@@ -21,6 +21,7 @@
 #include "tinyxml.h"
 #include "CSFunctionParser.h"
 #include "CSUseful.h"
+#include "CSArena.h"
 
 bool ReadTerm(ParameterScalar &PS, TiXmlElement &elem, const char* attr, double val)
 {
@@ -554,6 +555,16 @@ ParameterScalar::ParameterScalar(ParameterScalar* ps)
 	Copy(ps);
 }
 
+void* ParameterScalar::operator new(size_t size)
+{
+	return CSArena::Allocate(size);
+}
+
+void ParameterScalar::operator delete(void* ptr)
+{
+	CSArena::Free(ptr);
+}
+
 ParameterScalar::~ParameterScalar()
 {
 }
@@ -222,6 +222,10 @@ public:
 	ParameterScalar(ParameterScalar* ps);
 	~ParameterScalar();
 
+	//! Parameter scalars are allocated from the current arena, e.g. of the structure reading them. \sa CSArena
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+
 	void SetParameterSet(ParameterSet *paraSet);
 
 	int SetValue(const string value, bool Eval=true); ///returns eval-error-code